@@ -0,0 +1,248 @@
+#!/usr/bin/env bash
+
+# Runs herbstluftwm on a headless Xvfb, runs some scripted workloads and
+# prints for each of them the wall time, the X requests issued by
+# herbstluftwm and its resident memory, as json (default) or csv:
+#
+#   bench/bench.sh [json|csv] > results
+#
+# It is meant to be run via 'make bench' from the repository root. The size
+# of the workloads is controlled by these environment variables:
+#
+#   BENCH_CLIENTS   number of clients to map            (default 100)
+#   BENCH_FOCUS_CLIENTS
+#                   number of clients for the focus
+#                   tests                               (default 500)
+#   BENCH_FRAMES    number of nested frame splits       (default 50)
+#   BENCH_RULES     number of rules for the rules test  (default 500)
+#   BENCH_COMMANDS  number of commands, focus changes
+#                   and hooks                           (default 1000)
+#
+# The binaries are taken from HERBSTLUFTWM, HERBSTCLIENT and DUMMYCLIENT,
+# which default to the ones built in the repository.
+
+format=${1:-json}
+clients=${BENCH_CLIENTS:-100}
+focus_clients=${BENCH_FOCUS_CLIENTS:-500}
+frames=${BENCH_FRAMES:-50}
+rules=${BENCH_RULES:-500}
+commands=${BENCH_COMMANDS:-1000}
+herbstluftwm=${HERBSTLUFTWM:-./herbstluftwm}
+herbstclient=${HERBSTCLIENT:-./herbstclient}
+dummyclient=${DUMMYCLIENT:-./bench/dummyclient}
+
+case "$format" in
+    json|csv) ;;
+    *) echo "usage: $0 [json|csv]" >&2 ; exit 1 ;;
+esac
+
+if ! command -v Xvfb > /dev/null ; then
+    echo "$0: Xvfb is required to run the benchmarks" >&2
+    exit 1
+fi
+
+hc() { "$herbstclient" -s "$@" ;}
+
+die() {
+    echo "$0: $*" >&2
+    exit 1
+}
+
+now_ns() { date +%s%N ;}
+
+# pick a free display number
+display=99
+while [ -e "/tmp/.X11-unix/X$display" ] ; do
+    display=$((display + 1))
+done
+export DISPLAY=":$display"
+# do not talk to the socket of a running herbstluftwm
+unset HERBSTLUFTWM_SOCKET
+
+tmpdir=$(mktemp -d)
+pids=( )
+cleanup() {
+    for pid in "${pids[@]}" ; do
+        kill "$pid" 2> /dev/null
+    done
+    wait 2> /dev/null
+    rm -rf "$tmpdir"
+}
+trap cleanup EXIT
+
+Xvfb "$DISPLAY" -screen 0 1920x1080x24 -nolisten tcp > /dev/null 2>&1 &
+pids+=( $! )
+for i in $(seq 50) ; do
+    [ -e "/tmp/.X11-unix/X$display" ] && break
+    sleep 0.1
+done
+
+printf '#!/bin/sh\n' > "$tmpdir/autostart"
+chmod +x "$tmpdir/autostart"
+"$herbstluftwm" --autostart "$tmpdir/autostart" > "$tmpdir/log" 2>&1 &
+hlwm_pid=$!
+pids+=( $hlwm_pid )
+for i in $(seq 50) ; do
+    hc true 2> /dev/null && break
+    sleep 0.1
+done
+hc true || die "herbstluftwm did not start, see its output:"$'\n'"$(cat "$tmpdir/log")"
+hc attr profile.enabled true
+
+# waits until the focused tag has $1 clients
+wait_for_clients() {
+    for i in $(seq 300) ; do
+        [ "$(hc attr tags.focus.client_count)" -eq "$1" ] && return 0
+        sleep 0.05
+    done
+    die "timeout while waiting for $1 clients"
+}
+
+rss_kb() {
+    awk '/^VmRSS:/ { print $2 }' "/proc/$hlwm_pid/status"
+}
+
+commit=$(git rev-parse --short HEAD 2> /dev/null || echo unknown)
+results=( )
+
+# runs the scenario $1 with size $2, i.e. the command "$3 ..." and records it
+measure() {
+    local name="$1" size="$2"
+    shift 2
+    hc profile reset
+    local start=$(now_ns)
+    "$@"
+    local end=$(now_ns)
+    local wall_ms=$(( (end - start) / 1000000 ))
+    results+=( "$name $size $wall_ms $(hc attr profile.x_requests) $(rss_kb)" )
+}
+
+map_clients() {
+    "$dummyclient" "$clients" bench &
+    pids+=( $! )
+    dummy_pid=$!
+    wait_for_clients "$clients"
+}
+
+# Without --batch, every line is a request of its own which herbstclient
+# sends only after the previous one was answered. So herbstluftwm applies the
+# layout after every command, instead of once for all of them.
+cycle_layouts() {
+    for i in $(seq "$commands") ; do
+        echo "cycle_layout 1"
+    done | hc --stdin > /dev/null
+}
+
+split_frames() {
+    # every split nests the focused frame one level deeper
+    for i in $(seq "$frames") ; do
+        echo "split bottom 0.5"
+        echo "cycle_frame 1"
+    done | hc --stdin > /dev/null
+}
+
+add_rules() {
+    for i in $(seq "$rules") ; do
+        echo "rule class=nomatch$i tag=nomatch$i"
+        echo "rule instance~nomatch$i.* pseudotile=on"
+    done | hc --stdin --batch > /dev/null
+}
+
+remove_clients() {
+    kill "$dummy_pid"
+    wait_for_clients 0
+}
+
+# maps additional clients, such that there are $focus_clients
+add_focus_clients() {
+    local count=$((focus_clients - clients))
+    if [ "$count" -gt 0 ] ; then
+        "$dummyclient" "$count" benchfocus &
+        pids+=( $! )
+        focus_dummy_pid=$!
+    fi
+    wait_for_clients "$focus_clients"
+}
+
+remove_focus_clients() {
+    if [ -n "$focus_dummy_pid" ] ; then
+        kill "$focus_dummy_pid"
+        focus_dummy_pid=
+    fi
+    wait_for_clients "$clients"
+}
+
+focus_cycle() {
+    # every focus change raises the client and updates the focus layer
+    hc floating on
+    hc set raise_on_focus 1
+    for i in $(seq "$commands") ; do
+        echo "cycle_all 1"
+    done | hc --stdin > /dev/null
+    hc set raise_on_focus 0
+    hc floating off
+}
+
+floating_focus() {
+    # every directional focus change searches the neighbours of the client
+    hc floating on
+    for i in $(seq "$commands") ; do
+        echo "focus right"
+        echo "shift down"
+    done | hc --stdin > /dev/null
+    hc floating off
+}
+
+x_commands() {
+    for i in $(seq "$commands") ; do
+        "$herbstclient" true
+    done
+}
+
+socket_commands() {
+    for i in $(seq "$commands") ; do
+        echo "true"
+    done | hc --stdin > /dev/null
+}
+
+hooks() {
+    hc --wait --count "$commands" benchhook > /dev/null &
+    local waiter=$!
+    sleep 0.2
+    for i in $(seq "$commands") ; do
+        echo "emit_hook benchhook $i"
+    done | hc --stdin --batch > /dev/null
+    wait "$waiter"
+}
+
+measure map_clients         "$clients"  map_clients
+measure cycle_layout        "$commands" cycle_layouts
+measure split_frames        "$frames"   split_frames
+measure add_rules           "$rules"    add_rules
+remove_clients
+measure rules_apply         "$clients"  map_clients
+add_focus_clients
+measure focus_cycle         "$commands" focus_cycle
+measure floating_focus      "$commands" floating_focus
+remove_focus_clients
+measure ipc_x_commands      "$commands" x_commands
+measure ipc_socket_commands "$commands" socket_commands
+measure hooks               "$commands" hooks
+
+if [ "$format" = csv ] ; then
+    echo "commit,scenario,size,wall_ms,x_requests,rss_kb"
+    for r in "${results[@]}" ; do
+        set -- $r
+        echo "$commit,$1,$2,$3,$4,$5"
+    done
+else
+    echo "["
+    sep=""
+    for r in "${results[@]}" ; do
+        set -- $r
+        printf '%s  {"commit": "%s", "scenario": "%s", "size": %s, "wall_ms": %s, "x_requests": %s, "rss_kb": %s}' \
+            "$sep" "$commit" "$1" "$2" "$3" "$4" "$5"
+        sep=$',\n'
+    done
+    printf '\n]\n'
+fi
@@ -0,0 +1,46 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+// maps COUNT windows with the class CLASS and the instances CLASS0, CLASS1,
+// ... and keeps them open until it is killed. It is used by bench.sh to have
+// many clients without starting a process for each of them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s COUNT [CLASS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int count = atoi(argv[1]);
+    char* class_name = (argc >= 3) ? argv[2] : "bench";
+    Display* display = XOpenDisplay(NULL);
+    if (!display) {
+        fprintf(stderr, "%s: cannot open display\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    Window root = DefaultRootWindow(display);
+    char instance[128];
+    for (int i = 0; i < count; i++) {
+        Window win = XCreateSimpleWindow(display, root, 0, 0, 100, 100, 0,
+                                         0, 0);
+        snprintf(instance, sizeof(instance), "%s%d", class_name, i);
+        XClassHint hint;
+        hint.res_name = instance;
+        hint.res_class = class_name;
+        XSetClassHint(display, win, &hint);
+        XStoreName(display, win, instance);
+        XMapWindow(display, win);
+    }
+    XFlush(display);
+    XEvent event;
+    while (1) {
+        XNextEvent(display, &event);
+    }
+    return 0;
+}
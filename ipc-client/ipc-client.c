@@ -4,6 +4,7 @@
  * See LICENSE for details */
 
 #include "../src/ipc-protocol.h"
+#include "../src/ipc-socket-path.h"
 #include "ipc-client.h"
 #include "client-utils.h"
 
@@ -13,6 +14,10 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 // gui
 #include <X11/Xlib.h>
@@ -29,6 +34,7 @@ struct HCConnection {
     Atom        atom_output;
     Atom        atom_status;
     Window      root;
+    int         socket_fd; // -1 if the X11 transport is used
 };
 
 HCConnection* hc_connect() {
@@ -49,6 +55,7 @@ HCConnection* hc_connect_to_display(Display* display) {
         return con;
     }
     memset(con, 0, sizeof(HCConnection));
+    con->socket_fd = -1;
     con->display = display;
     con->root = DefaultRootWindow(con->display);
     con->atom_args = XInternAtom(con->display, HERBST_IPC_ARGS_ATOM, False);
@@ -58,6 +65,9 @@ HCConnection* hc_connect_to_display(Display* display) {
 }
 
 void hc_disconnect(HCConnection* con) {
+    if (con->socket_fd >= 0) {
+        close(con->socket_fd);
+    }
     if (con->client_window) {
         XDestroyWindow(con->display, con->client_window);
     }
@@ -92,6 +102,9 @@ bool hc_create_client_window(HCConnection* con) {
 
 bool hc_send_command(HCConnection* con, int argc, char* argv[],
                      GString** ret_out, int* ret_status) {
+    if (con->socket_fd >= 0) {
+        return hc_socket_send_command(con, argc, argv, ret_out, ret_status);
+    }
     if (!hc_create_client_window(con)) {
         return false;
     }
@@ -153,6 +166,217 @@ bool hc_send_command(HCConnection* con, int argc, char* argv[],
     return true;
 }
 
+// unix socket transport
+
+GString* hc_default_socket_path() {
+    GString* path = g_string_new("");
+    ipc_socket_client_path(path, getenv("DISPLAY"));
+    return path;
+}
+
+HCConnection* hc_connect_socket(const char* path) {
+    GString* default_path = NULL;
+    if (!path) {
+        default_path = hc_default_socket_path();
+        path = default_path->str;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    struct stat st;
+    int fd = -1;
+    // only talk to sockets of our own user, because /tmp is world writable
+    if (strlen(path) < sizeof(addr.sun_path)
+        && 0 == stat(path, &st) && S_ISSOCK(st.st_mode)
+        && st.st_uid == getuid())
+    {
+        strcpy(addr.sun_path, path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && 0 != connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (default_path) {
+        g_string_free(default_path, true);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+    HCConnection* con = malloc(sizeof(struct HCConnection));
+    if (!con) {
+        close(fd);
+        return con;
+    }
+    memset(con, 0, sizeof(HCConnection));
+    con->socket_fd = fd;
+    return con;
+}
+
+static bool write_all(int fd, const char* buf, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, buf, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        length -= n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, char* buf, size_t length) {
+    while (length > 0) {
+        ssize_t n = read(fd, buf, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool hc_socket_send_message(HCConnection* con, uint32_t type,
+                            const char* payload, size_t length) {
+    HerbstIpcHeader header;
+    header.type = type;
+    header.length = length;
+    return write_all(con->socket_fd, (const char*)&header, sizeof(header))
+        && write_all(con->socket_fd, payload, length);
+}
+
+GString* hc_socket_receive_message(HCConnection* con, uint32_t* type) {
+    HerbstIpcHeader header;
+    if (!read_all(con->socket_fd, (char*)&header, sizeof(header))
+        || header.length > HERBST_IPC_MAX_MESSAGE_LENGTH) {
+        return NULL;
+    }
+    GString* payload = g_string_sized_new(header.length);
+    g_string_set_size(payload, header.length);
+    if (!read_all(con->socket_fd, payload->str, header.length)) {
+        g_string_free(payload, true);
+        return NULL;
+    }
+    *type = header.type;
+    return payload;
+}
+
+// serializes argv into a command message payload
+static void append_arguments(GString* payload, int argc, char* argv[]) {
+    for (int i = 0; i < argc; i++) {
+        g_string_append_len(payload, argv[i], strlen(argv[i]) + 1);
+    }
+}
+
+// sends the arguments in a message of the given type and receives the
+// HERBST_IPC_MSG_RESPONSE to it
+static bool hc_socket_request(HCConnection* con, uint32_t msg_type,
+                              int argc, char* argv[],
+                              GString** ret_out, int* ret_status) {
+    GString* payload = g_string_new("");
+    append_arguments(payload, argc, argv);
+    bool sent = hc_socket_send_message(con, msg_type,
+                                       payload->str, payload->len);
+    g_string_free(payload, true);
+    if (!sent) {
+        return false;
+    }
+    uint32_t type;
+    GString* response = hc_socket_receive_message(con, &type);
+    if (!response) {
+        return false;
+    }
+    int32_t status;
+    if (type != HERBST_IPC_MSG_RESPONSE || response->len < sizeof(status)) {
+        g_string_free(response, true);
+        return false;
+    }
+    memcpy(&status, response->str, sizeof(status));
+    g_string_erase(response, 0, sizeof(status));
+    *ret_status = status;
+    *ret_out = response;
+    return true;
+}
+
+bool hc_socket_send_command(HCConnection* con, int argc, char* argv[],
+                            GString** ret_out, int* ret_status) {
+    return hc_socket_request(con, HERBST_IPC_MSG_COMMAND, argc, argv,
+                             ret_out, ret_status);
+}
+
+bool hc_send_batch(HCConnection* con, int count, int argcs[], char** argvs[],
+                   GString* ret_out[], int ret_status[]) {
+    if (con->socket_fd < 0) {
+        // the X protocol has no batches, so send one command after another
+        for (int i = 0; i < count; i++) {
+            if (!hc_send_command(con, argcs[i], argvs[i],
+                                 ret_out + i, ret_status + i)) {
+                for (int j = 0; j < i; j++) {
+                    g_string_free(ret_out[j], true);
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+    GString* payload = g_string_new("");
+    GString* command = g_string_new("");
+    for (int i = 0; i < count; i++) {
+        g_string_truncate(command, 0);
+        append_arguments(command, argcs[i], argvs[i]);
+        uint32_t length = command->len;
+        g_string_append_len(payload, (const char*)&length, sizeof(length));
+        g_string_append_len(payload, command->str, command->len);
+    }
+    bool sent = hc_socket_send_message(con, HERBST_IPC_MSG_BATCH,
+                                       payload->str, payload->len);
+    g_string_free(command, true);
+    g_string_free(payload, true);
+    if (!sent) {
+        return false;
+    }
+    uint32_t type;
+    GString* response = hc_socket_receive_message(con, &type);
+    if (!response) {
+        return false;
+    }
+    // split the response into the results of the single commands
+    size_t pos = 0;
+    int i;
+    for (i = 0; i < count && type == HERBST_IPC_MSG_BATCH_RESPONSE; i++) {
+        int32_t status;
+        uint32_t length;
+        if (response->len - pos < sizeof(status) + sizeof(length)) {
+            break;
+        }
+        memcpy(&status, response->str + pos, sizeof(status));
+        pos += sizeof(status);
+        memcpy(&length, response->str + pos, sizeof(length));
+        pos += sizeof(length);
+        if (length > response->len - pos) {
+            break;
+        }
+        ret_status[i] = status;
+        ret_out[i] = g_string_new_len(response->str + pos, length);
+        pos += length;
+    }
+    g_string_free(response, true);
+    if (i < count) {
+        for (int j = 0; j < i; j++) {
+            g_string_free(ret_out[j], true);
+        }
+        return false;
+    }
+    return true;
+}
+
 bool hc_send_command_once(int argc, char* argv[],
                           GString** ret_out, int* ret_status) {
     HCConnection* con = hc_connect();
@@ -182,6 +406,10 @@ static Window get_hook_window(Display* display) {
 }
 
 bool hc_hook_window_connect(HCConnection* con) {
+    if (!con->display) {
+        // hooks are only available via X
+        return false;
+    }
     if (con->hook_window) {
         return true;
     }
@@ -244,3 +472,42 @@ bool hc_next_hook(HCConnection* con, int* argc, char** argv[]) {
     }
     return true;
 }
+
+bool hc_socket_subscribe(HCConnection* con, int filterc, char* filterv[],
+                         GString** ret_out, int* ret_status) {
+    return hc_socket_request(con, HERBST_IPC_MSG_SUBSCRIBE, filterc, filterv,
+                             ret_out, ret_status);
+}
+
+bool hc_socket_next_hook(HCConnection* con, int* argc, char** argv[],
+                         uint64_t* sequence, uint32_t* dropped) {
+    uint32_t type;
+    GString* message = hc_socket_receive_message(con, &type);
+    if (!message) {
+        return false;
+    }
+    size_t offset = sizeof(*sequence) + sizeof(*dropped);
+    if (type != HERBST_IPC_MSG_HOOK || message->len < offset
+        || (message->len > offset && message->str[message->len - 1] != '\0')) {
+        g_string_free(message, true);
+        return false;
+    }
+    memcpy(sequence, message->str, sizeof(*sequence));
+    memcpy(dropped, message->str + sizeof(*sequence), sizeof(*dropped));
+    // every argument is terminated by a null byte
+    int count = 0;
+    for (size_t i = offset; i < message->len; i++) {
+        if (message->str[i] == '\0') count++;
+    }
+    char** list = g_new(char*, count);
+    char* arg = message->str + offset;
+    for (int i = 0; i < count; i++) {
+        list[i] = arg;
+        arg += strlen(arg) + 1;
+    }
+    *argc = count;
+    *argv = argv_duplicate(count, list); // has to be freed by caller
+    g_free(list);
+    g_string_free(message, true);
+    return true;
+}
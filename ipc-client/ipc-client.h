@@ -6,6 +6,8 @@
 #include <X11/Xlib.h>
 #include <glib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #ifndef __HERBSTLUFT_IPC_CLIENT_H_
 #define __HERBSTLUFT_IPC_CLIENT_H_
@@ -22,6 +24,34 @@ bool hc_send_command(HCConnection* con, int argc, char* argv[],
                      GString** ret_out, int* ret_status);
 bool hc_send_command_once(int argc, char* argv[],
                           GString** ret_out, int* ret_status);
+/* sends count commands, the i'th command is given by argcs[i] and argvs[i],
+ * and its output and status are returned in ret_out[i] and ret_status[i].
+ * Via the socket, all commands are sent and answered in one message. */
+bool hc_send_batch(HCConnection* con, int count, int argcs[], char** argvs[],
+                   GString* ret_out[], int ret_status[]);
+
+/* unix socket transport: hc_send_command() automatically uses the socket
+ * for connections created by hc_connect_socket() */
+GString* hc_default_socket_path();
+/* connect to the socket at path, or to the default path if path is NULL */
+HCConnection* hc_connect_socket(const char* path);
+bool hc_socket_send_command(HCConnection* con, int argc, char* argv[],
+                            GString** ret_out, int* ret_status);
+bool hc_socket_send_message(HCConnection* con, uint32_t type,
+                            const char* payload, size_t length);
+/* returns the payload of the next message or NULL on error */
+GString* hc_socket_receive_message(HCConnection* con, uint32_t* type);
+
+/* subscribe a socket connection to the hooks whose i'th argument matches
+ * the regex filterv[i]. On an invalid filter, ret_status is non-zero and
+ * ret_out contains the error message. */
+bool hc_socket_subscribe(HCConnection* con, int filterc, char* filterv[],
+                         GString** ret_out, int* ret_status);
+/* waits for the next hook on a subscribed socket connection. Besides the
+ * hook, its sequence number and the number of hooks that were dropped right
+ * before it are returned. */
+bool hc_socket_next_hook(HCConnection* con, int* argc, char** argv[],
+                         uint64_t* sequence, uint32_t* dropped);
 
 bool hc_hook_window_connect(HCConnection* con);
 bool hc_next_hook(HCConnection* con, int* argc, char** argv[]);
@@ -28,6 +28,10 @@ bool g_null_char_as_delim = false; // if true, the null character is used as del
 bool g_print_last_arg_only = false; // if true, prints only the last argument of a hook
 int g_wait_for_hook = 0; // if set, do not execute command but wait
 bool g_quiet = false;
+bool g_use_socket = false; // if true, send commands via the unix socket
+char* g_socket_path = NULL; // NULL means the default socket path
+int g_read_stdin = 0; // if set, read the commands from stdin
+int g_batch = 0; // if set, send the commands from stdin in batches
 regex_t* g_hook_regex = NULL;
 int g_hook_regex_count = 0;
 int g_hook_count = 1; // count of hooks to wait for, 0 means: forever
@@ -73,8 +77,9 @@ void print_help(char* command, FILE* file) {
 
     fprintf(file,
         "Usage: %s [OPTIONS] COMMAND [ARGS ...]\n"
-        "       %s [OPTIONS] [--wait|--idle] [FILTER ...]\n",
-        command, command);
+        "       %s [OPTIONS] [--wait|--idle] [FILTER ...]\n"
+        "       %s [OPTIONS] --stdin\n",
+        command, command, command);
 
     char* help_string =
         "Send a COMMAND with optional arguments ARGS to a running "
@@ -91,6 +96,16 @@ void print_help(char* command, FILE* file) {
             "received and printed. The default of COUNT is 1.\n"
         "\t-q, --quiet: Do not print error messages if herbstclient cannot "
             "connect to the running herbstluftwm instance.\n"
+        "\t-s, --socket[=PATH]: Send the command via the unix socket at PATH "
+            "instead of via X. PATH defaults to $" HERBST_IPC_SOCKET_ENV
+            " or to the socket of the herbstluftwm instance on $DISPLAY.\n"
+        "\t--stdin: Read commands from stdin, one per line (or null "
+            "character separated if -0 is given), and send them via one "
+            "connection. For each command, its exit status, a tab and its "
+            "output are printed.\n"
+        "\t--batch: Let --stdin send all commands up to an empty line "
+            "at once and print their responses after all of them have been "
+            "executed.\n"
         "\t-v, --version: Print the herbstclient version. To get the "
             "herbstluftwm version, use 'herbstclient version'.\n"
         "\t-h, --help: Print this help."
@@ -99,16 +114,61 @@ void print_help(char* command, FILE* file) {
     fputs(help_string, file);
 }
 
+static void print_hook(int hook_argc, char** hook_argv) {
+    if (g_print_last_arg_only) {
+        // just drop hooks without content
+        if (hook_argc >= 1) {
+            printf("%s", hook_argv[hook_argc-1]);
+        }
+    } else {
+        // just print as list
+        for (int i = 0; i < hook_argc; i++) {
+            printf("%s%s", i ? "\t" : "", hook_argv[i]);
+        }
+    }
+    if (g_null_char_as_delim) {
+        putchar(0);
+    } else {
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
 int main_hook(int argc, char* argv[]) {
-    init_hook_regex(argc, argv);
-    Display* display = XOpenDisplay(NULL);
-    if (!display) {
-        if (!g_quiet) {
-            fprintf(stderr, "Cannot open display\n");
+    Display* display = NULL;
+    HCConnection* con;
+    if (g_use_socket) {
+        // the filters are matched by herbstluftwm, so only matching hooks
+        // are received
+        con = hc_connect_socket(g_socket_path);
+        GString* output = NULL;
+        int status = 0;
+        if (!con || !hc_socket_subscribe(con, argc, argv, &output, &status)) {
+            if (!g_quiet) {
+                fprintf(stderr, "Cannot subscribe to hooks via the socket\n");
+            }
+            if (con) hc_disconnect(con);
+            return EXIT_FAILURE;
         }
-        return EXIT_FAILURE;
+        if (status != 0) {
+            fputs(output->str, stderr);
+            g_string_free(output, true);
+            hc_disconnect(con);
+            return EXIT_FAILURE;
+        }
+        g_string_free(output, true);
+    } else {
+        init_hook_regex(argc, argv);
+        display = XOpenDisplay(NULL);
+        if (!display) {
+            if (!g_quiet) {
+                fprintf(stderr, "Cannot open display\n");
+            }
+            destroy_hook_regex();
+            return EXIT_FAILURE;
+        }
+        con = hc_connect_to_display(display);
     }
-    HCConnection* con = hc_connect_to_display(display);
     signal(SIGTERM, quit_herbstclient);
     signal(SIGINT,  quit_herbstclient);
     signal(SIGQUIT, quit_herbstclient);
@@ -116,12 +176,28 @@ int main_hook(int argc, char* argv[]) {
         bool print_signal = true;
         int hook_argc;
         char** hook_argv;
-        if (!hc_next_hook(con, &hook_argc, &hook_argv)) {
+        bool received;
+        uint64_t sequence;
+        uint32_t dropped = 0;
+        if (g_use_socket) {
+            received = hc_socket_next_hook(con, &hook_argc, &hook_argv,
+                                           &sequence, &dropped);
+        } else {
+            received = hc_next_hook(con, &hook_argc, &hook_argv);
+        }
+        if (!received) {
             fprintf(stderr, "Cannot listen for hooks\n");
             destroy_hook_regex();
             return EXIT_FAILURE;
         }
-        for (int i = 0; i < argc && i < hook_argc; i++) {
+        if (dropped > 0) {
+            // tell the reader that it missed hooks, regardless of the filter
+            char count[32];
+            snprintf(count, sizeof(count), "%u", (unsigned int)dropped);
+            char* notice[] = { (char*)"hooks_dropped", count };
+            print_hook(2, notice);
+        }
+        for (int i = 0; i < g_hook_regex_count && i < hook_argc; i++) {
             if (0 != regexec(g_hook_regex + i, hook_argv[i], 0, NULL, 0)) {
                 // found an regex that did not match
                 // so skip this
@@ -130,23 +206,7 @@ int main_hook(int argc, char* argv[]) {
             }
         }
         if (print_signal) {
-            if (g_print_last_arg_only) {
-                // just drop hooks without content
-                if (hook_argc >= 1) {
-                    printf("%s", hook_argv[hook_argc-1]);
-                }
-            } else {
-                // just print as list
-                for (int i = 0; i < hook_argc; i++) {
-                    printf("%s%s", i ? "\t" : "", hook_argv[i]);
-                }
-            }
-            if (g_null_char_as_delim) {
-                putchar(0);
-            } else {
-                printf("\n");
-            }
-            fflush(stdout);
+            print_hook(hook_argc, hook_argv);
         }
         argv_free(hook_argc, hook_argv);
         if (print_signal) {
@@ -159,11 +219,142 @@ int main_hook(int argc, char* argv[]) {
         }
     }
     hc_disconnect(con);
-    XCloseDisplay(display);
+    if (display) {
+        XCloseDisplay(display);
+    }
     destroy_hook_regex();
     return 0;
 }
 
+// reads the next record terminated by delim, returns false on end of file
+static bool read_record(FILE* file, char delim, GString* record) {
+    g_string_truncate(record, 0);
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == delim) {
+            return true;
+        }
+        g_string_append_c(record, c);
+    }
+    return record->len > 0;
+}
+
+static void print_response(int status, GString* output) {
+    // the delimiter replaces the trailing newline
+    if (output->len > 0 && output->str[output->len - 1] == '\n') {
+        g_string_truncate(output, output->len - 1);
+    }
+    printf("%d\t%s", status, output->str);
+    putchar(g_null_char_as_delim ? '\0' : '\n');
+}
+
+typedef struct {
+    int         argc;
+    char**      argv; // NULL if the command could not be parsed
+    GString*    output;
+    int         status;
+} StdinCommand;
+
+// parses line into cmd, returns false if the line contains no command
+static bool parse_command(const char* line, StdinCommand* cmd) {
+    GError* error = NULL;
+    cmd->output = NULL;
+    // arguments are split and quoted like in the shell
+    if (g_shell_parse_argv(line, &cmd->argc, &cmd->argv, &error)) {
+        return true;
+    }
+    bool empty = g_error_matches(error, G_SHELL_ERROR,
+                                 G_SHELL_ERROR_EMPTY_STRING);
+    // keep one response per command
+    cmd->argv = NULL;
+    cmd->output = g_string_new(error->message);
+    cmd->status = HERBST_INVALID_ARGUMENT;
+    g_error_free(error);
+    if (empty) {
+        g_string_free(cmd->output, true);
+    }
+    return !empty;
+}
+
+// sends the commands and prints their responses in order. Returns false if
+// the commands could not be sent.
+static bool send_commands(HCConnection* con, StdinCommand* cmds, int count) {
+    int* argcs = g_new(int, count);
+    char*** argvs = g_new(char**, count);
+    GString** outputs = g_new(GString*, count);
+    int* statuses = g_new(int, count);
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        if (cmds[i].argv) {
+            argcs[sent] = cmds[i].argc;
+            argvs[sent] = cmds[i].argv;
+            sent++;
+        }
+    }
+    bool suc = hc_send_batch(con, sent, argcs, argvs, outputs, statuses);
+    int j = 0;
+    for (int i = 0; i < count; i++) {
+        if (cmds[i].argv) {
+            g_strfreev(cmds[i].argv);
+            if (!suc) continue;
+            cmds[i].output = outputs[j];
+            cmds[i].status = statuses[j];
+            j++;
+        }
+        if (cmds[i].output) {
+            print_response(cmds[i].status, cmds[i].output);
+            g_string_free(cmds[i].output, true);
+        }
+    }
+    fflush(stdout);
+    g_free(argcs);
+    g_free(argvs);
+    g_free(outputs);
+    g_free(statuses);
+    return suc;
+}
+
+int main_stdin() {
+    HCConnection* con = g_use_socket ? hc_connect_socket(g_socket_path)
+                                     : hc_connect();
+    if (!con) {
+        if (!g_quiet) {
+            fprintf(stderr, "Error: Could not connect to herbstluftwm.\n");
+        }
+        return EXIT_FAILURE;
+    }
+    char delim = g_null_char_as_delim ? '\0' : '\n';
+    GString* line = g_string_new("");
+    StdinCommand* cmds = NULL;
+    int count = 0;
+    int command_status = 0;
+    bool more_input = true;
+    while (more_input) {
+        more_input = read_record(stdin, delim, line);
+        bool end_of_batch = !more_input || !g_batch || line->len == 0;
+        if (more_input) {
+            cmds = g_renew(StdinCommand, cmds, count + 1);
+            if (parse_command(line->str, cmds + count)) {
+                count++;
+            }
+        }
+        if (!end_of_batch || count == 0) {
+            continue;
+        }
+        if (!send_commands(con, cmds, count)) {
+            fprintf(stderr, "Error: Could not send command.\n");
+            command_status = EXIT_FAILURE;
+            break;
+        }
+        command_status = cmds[count - 1].status;
+        count = 0;
+    }
+    g_free(cmds);
+    g_string_free(line, true);
+    hc_disconnect(con);
+    return command_status;
+}
+
 int main(int argc, char* argv[]) {
     static struct option long_options[] = {
         {"no-newline", 0, 0, 'n'},
@@ -173,6 +364,9 @@ int main(int argc, char* argv[]) {
         {"count", 1, 0, 'c'},
         {"idle", 0, 0, 'i'},
         {"quiet", 0, 0, 'q'},
+        {"socket", 2, 0, 's'},
+        {"stdin", 0, &g_read_stdin, 1},
+        {"batch", 0, &g_batch, 1},
         {"version", 0, 0, 'v'},
         {"help", 0, 0, 'h'},
         {0, 0, 0, 0}
@@ -180,9 +374,12 @@ int main(int argc, char* argv[]) {
     // parse options
     while (1) {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "+n0lwc:iqhv", long_options, &option_index);
+        int c = getopt_long(argc, argv, "+n0lwc:iqs::hv", long_options, &option_index);
         if (c == -1) break;
         switch (c) {
+            case 0:
+                /* ignore recognized long option */
+                break;
             case 'i':
                 g_hook_count = 0;
                 g_wait_for_hook = 1;
@@ -206,6 +403,10 @@ int main(int argc, char* argv[]) {
             case 'q':
                 g_quiet = true;
                 break;
+            case 's':
+                g_use_socket = true;
+                g_socket_path = optarg;
+                break;
             case 'h':
                 print_help(argv[0], stdout);
                 exit(EXIT_SUCCESS);
@@ -217,6 +418,13 @@ int main(int argc, char* argv[]) {
         }
     }
     int arg_index = optind; // index of the first-non-option argument
+    if (g_read_stdin) {
+        if (argc - arg_index > 0 || g_wait_for_hook) {
+            print_help(argv[0], stderr);
+            exit(EXIT_FAILURE);
+        }
+        return main_stdin();
+    }
     if ((argc - arg_index == 0) && !g_wait_for_hook) {
         // if there are no non-option arguments, and no --idle/--wait, display
         // the help and exit
@@ -230,8 +438,22 @@ int main(int argc, char* argv[]) {
         command_status = main_hook(argc-arg_index, argv+arg_index);
     } else {
         GString* output;
-        bool suc = hc_send_command_once(argc-arg_index, argv+arg_index,
-                                        &output, &command_status);
+        bool suc;
+        if (g_use_socket) {
+            HCConnection* con = hc_connect_socket(g_socket_path);
+            if (!con) {
+                if (!g_quiet) {
+                    fprintf(stderr, "Error: Could not connect to the socket.\n");
+                }
+                return EXIT_FAILURE;
+            }
+            suc = hc_send_command(con, argc-arg_index, argv+arg_index,
+                                  &output, &command_status);
+            hc_disconnect(con);
+        } else {
+            suc = hc_send_command_once(argc-arg_index, argv+arg_index,
+                                       &output, &command_status);
+        }
         if (!suc) {
             fprintf(stderr, "Error: Could not send command.\n");
             return EXIT_FAILURE;
@@ -34,5 +34,8 @@ complete -fc herbstclient -s i -l idle -d 'Wait for hooks instead of executing c
 complete -fc herbstclient -s w -l wait -d 'Same as --idle but exit after first --count hooks.'
 complete -fc herbstclient -s c -l count -r -d 'Let --wait exit after COUNT hooks were received and printed.'
 complete -fc herbstclient -s q -l quiet -d 'Do not print error messages if herbstclient cannot connect to the running herbstluftwm instance.'
+complete -c herbstclient -s s -l socket -d 'Send the command via the unix socket instead of via X.'
+complete -fc herbstclient -l stdin -d 'Read commands from stdin and send them via one connection.'
+complete -fc herbstclient -l batch -d 'Send the commands from --stdin in batches separated by empty lines.'
 complete -fc herbstclient -s v -l version -d 'Print the herbstclient version.'
 complete -fc herbstclient -s h -l help -d 'Print the herbstclient usage with its command line options.'
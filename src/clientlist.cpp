@@ -53,6 +53,14 @@ static int client_get_scheme_triple_idx(HSClient* client);
 
 static bool g_startup = true; // whether hlwm is starting up and is not in the
                               // main event loop yet
+// the title hooks of each client are coalesced with their own key
+#define TITLE_HOOK_KEY_PREFIX "window_title_changed "
+
+static void client_title_hook_key(HSClient* client, char* key) {
+    snprintf(key, STRING_BUF_SIZE, TITLE_HOOK_KEY_PREFIX "0x%lx",
+             client->window);
+}
+
 static HSClient* create_client() {
     HSClient* hc = g_new0(HSClient, 1);
     hsobject_init(&hc->object);
@@ -60,7 +68,12 @@ static HSClient* create_client() {
     hc->float_size.width = 100;
     hc->float_size.height = 100;
     hc->title = g_string_new("");
+    hc->window_class = NULL;
+    hc->window_instance = NULL;
+    hc->window_role = NULL;
+    hc->window_type = -1;
     hc->urgent = false;
+    hc->urgent_counted = false;
     hc->fullscreen = false;
     hc->ewmhfullscreen = false;
     hc->pseudotile = false;
@@ -81,12 +94,18 @@ static void fetch_colors() {
 void clientlist_init() {
     // init regex simple..
     fetch_colors();
-    g_wmatom[WMProtocols] = XInternAtom(g_display, "WM_PROTOCOLS", False);
-    g_wmatom[WMDelete] = XInternAtom(g_display, "WM_DELETE_WINDOW", False);
-    g_wmatom[WMState] = XInternAtom(g_display, "WM_STATE", False);
-    g_wmatom[WMTakeFocus] = XInternAtom(g_display, "WM_TAKE_FOCUS", False);
+    g_wmatom[WMProtocols] = ATOM("WM_PROTOCOLS");
+    g_wmatom[WMDelete] = ATOM("WM_DELETE_WINDOW");
+    g_wmatom[WMState] = ATOM("WM_STATE");
+    g_wmatom[WMTakeFocus] = ATOM("WM_TAKE_FOCUS");
     // init actual client list
     g_client_object = hsobject_create_and_link(hsobject_root(), "clients");
+    HSAttribute attributes[] = {
+        ATTRIBUTE_UINT("configures", g_decoration_configure_count, ATTR_READ_ONLY),
+        ATTRIBUTE_UINT("configures_elided", g_decoration_configure_elided_count, ATTR_READ_ONLY),
+        ATTRIBUTE_LAST,
+    };
+    hsobject_set_attributes(g_client_object, attributes);
     g_clients = g_hash_table_new_full(g_int_hash, g_int_equal,
                                       NULL, (GDestroyNotify)client_destroy);
 }
@@ -166,16 +185,12 @@ static void client_attr_tag(void* data, GString* output) {
 
 static void client_attr_class(void* data, GString* output) {
     HSClient* client = (HSClient*) data;
-    GString* ret = window_class_to_g_string(g_display, client->window);
-    g_string_append(output, ret->str);
-    g_string_free(ret, true);
+    g_string_append(output, client->window_class->str);
 }
 
 static void client_attr_instance(void* data, GString* output) {
     HSClient* client = (HSClient*) data;
-    GString* ret = window_instance_to_g_string(g_display, client->window);
-    g_string_append(output, ret->str);
-    g_string_free(ret, true);
+    g_string_append(output, client->window_instance->str);
 }
 
 static GString* client_attr_fullscreen(HSAttribute* attr) {
@@ -212,17 +227,29 @@ static GString* client_attr_sh_floating(HSAttribute* attr) {
     return NULL;
 }
 
-HSClient* manage_client(Window win, bool force_unmanage) {
-    if (is_herbstluft_window(g_display, win)) {
-        // ignore our own window
+HSClient* manage_client(Window win, bool force_unmanage,
+                        const XWindowAttributes* window_attributes) {
+    if (get_client_from_window(win)) {
         return NULL;
     }
-    if (get_client_from_window(win)) {
+    // fetch the class and the window type only once, they are needed here
+    // and then cached for the rules and the client attributes
+    GString* window_class;
+    GString* window_instance;
+    window_class_hint_to_g_strings(g_display, win,
+                                   &window_class, &window_instance);
+    if (!strcmp(window_class->str, HERBST_FRAME_CLASS)) {
+        // ignore our own window
+        g_string_free(window_class, true);
+        g_string_free(window_instance, true);
         return NULL;
     }
-    if (ewmh_is_desktop_window(win)) {
+    int window_type = ewmh_get_window_type(win);
+    if (window_type == NetWmWindowTypeDesktop) {
+        g_string_free(window_class, true);
+        g_string_free(window_instance, true);
         DesktopWindow::registerDesktop(win);
-        monitor_restack(get_current_monitor());
+        DesktopWindow::lowerDesktopWindows();
         XMapWindow(g_display, win);
         return NULL;
     }
@@ -232,13 +259,24 @@ HSClient* manage_client(Window win, bool force_unmanage) {
     HSMonitor* m = get_current_monitor();
     // set to window properties
     client->window = win;
+    client->window_class = window_class;
+    client->window_instance = window_instance;
+    client->window_type = window_type;
+    client_update_window_role(client);
     client_update_title(client);
 
     unsigned int border, depth;
     Window root_win;
     int x, y;
     unsigned int w, h;
-    XGetGeometry(g_display, win, &root_win, &x, &y, &w, &h, &border, &depth);
+    if (window_attributes) {
+        x = window_attributes->x;
+        y = window_attributes->y;
+        w = window_attributes->width;
+        h = window_attributes->height;
+    } else {
+        XGetGeometry(g_display, win, &root_win, &x, &y, &w, &h, &border, &depth);
+    }
     // treat wanted coordinates as floating coords
     client->float_size.x = x;
     client->float_size.y = y;
@@ -291,15 +329,14 @@ HSClient* manage_client(Window win, bool force_unmanage) {
     // insert window to the stack
     client->slice = slice_create_client(client);
     stack_insert_slice(client->tag->stack, client->slice);
+    rectindex_insert(client->tag->rects, client);
+    tag_flags_add_client(client->tag, client);
     // insert window to the tag
     frame_insert_client(lookup_frame(client->tag->frame, changes.tree_index->str), client);
     client_update_wm_hints(client);
     updatesizehints(client);
     if (changes.focus) {
         // give focus to window if wanted
-        // TODO: make this faster!
-        // WARNING: this solution needs O(C + exp(D)) time where W is the count
-        // of clients on this tag and D is the depth of the binary layout tree
         frame_focus_client(client->tag->frame, client);
     }
 
@@ -325,7 +362,6 @@ HSClient* manage_client(Window win, bool force_unmanage) {
     hsobject_set_attributes(&client->object, attributes);
 
     ewmh_window_update_tag(client->window, client->tag);
-    tag_set_flags_dirty();
     client_set_fullscreen(client, changes.fullscreen);
     ewmh_update_window_state(client);
     // add client after setting the correct tag for the new client
@@ -398,7 +434,6 @@ void unmanage_client(Window win) {
     tag_update_focus_layer(tag);
     if (m) monitor_apply_layout(m);
     ewmh_remove_client(win);
-    tag_set_flags_dirty();
 
     // Get the current client and update the windows focus.
     client = frame_focused_client(tag->frame);
@@ -410,12 +445,18 @@ void unmanage_client(Window win) {
 // destroys a special client
 void client_destroy(HSClient* client) {
     hsobject_unlink(g_client_object, &client->object);
+    // do not report title changes of a window that is gone
+    char key[STRING_BUF_SIZE];
+    client_title_hook_key(client, key);
+    hook_drop_coalesced(key);
     decoration_free(&client->dec);
     if (lastfocus == client) {
         lastfocus = NULL;
     }
     if (client->tag && client->slice) {
         stack_remove_slice(client->tag->stack, client->slice);
+        rectindex_remove(client->tag->rects, client);
+        tag_flags_remove_client(client->tag, client);
     }
     if (client->slice) {
         slice_destroy(client->slice);
@@ -427,6 +468,15 @@ void client_destroy(HSClient* client) {
     if (client->window_str) {
         g_string_free(client->window_str, true);
     }
+    if (client->window_class) {
+        g_string_free(client->window_class, true);
+    }
+    if (client->window_instance) {
+        g_string_free(client->window_instance, true);
+    }
+    if (client->window_role) {
+        g_string_free(client->window_role, true);
+    }
     if (client->keymask) {
         g_string_free(client->keymask, true);
     }
@@ -466,7 +516,10 @@ void client_window_unfocus_last() {
     XSetInputFocus(g_display, g_root, RevertToPointerRoot, CurrentTime);
     if (lastfocus) {
         /* only emit the hook if the focus *really* changes */
-        hook_emit_list("focus_changed", "0x0", "", NULL);
+        const char* argv[] = { "focus_changed", "0x0", "" };
+        // the title changes of the previous client are outdated now
+        hook_drop_coalesced_prefix(TITLE_HOOK_KEY_PREFIX, NULL);
+        hook_emit_coalesced(argv[0], LENGTH(argv), argv);
         ewmh_update_active_window(None);
         tag_update_each_focus_layer();
 
@@ -497,7 +550,13 @@ void client_window_focus(HSClient* client) {
         const char* title = client ? client->title->str : "?";
         char winid_str[STRING_BUF_SIZE];
         snprintf(winid_str, STRING_BUF_SIZE, "0x%x", (unsigned int)client->window);
-        hook_emit_list("focus_changed", winid_str, title, NULL);
+        const char* argv[] = { "focus_changed", winid_str, title };
+        // pending title changes of other clients must not be emitted after
+        // this hook
+        char key[STRING_BUF_SIZE];
+        client_title_hook_key(client, key);
+        hook_drop_coalesced_prefix(TITLE_HOOK_KEY_PREFIX, key);
+        hook_emit_coalesced(argv[0], LENGTH(argv), argv);
     }
 
     // change window-colors
@@ -543,6 +602,10 @@ static void client_resize_fullscreen(HSClient* client, HSMonitor* m) {
 void client_raise(HSClient* client) {
     assert(client);
     stack_raise_slide(client->tag->stack, client->slice);
+    HSMonitor* monitor = find_monitor_with_tag(client->tag);
+    if (monitor) {
+        monitor_restack(monitor);
+    }
 }
 
 static HSDecorationScheme client_scheme_from_triple(HSClient* client, int tripidx) {
@@ -813,6 +876,8 @@ static void client_set_urgent_force(HSClient* client, bool state) {
     hook_emit_list("urgent", state ? "on" : "off", winid_str, NULL);
 
     client->urgent = state;
+    // report changes to tags, also for windows without WM_HINTS
+    tag_flags_update_urgent(client);
 
     client_setup_border(client, client == frame_focused_client(g_cur_frame));
 
@@ -828,8 +893,6 @@ static void client_set_urgent_force(HSClient* client, bool state) {
 
     XSetWMHints(g_display, client->window, wmh);
     XFree(wmh);
-    // report changes to tags
-    tag_set_flags_dirty();
 }
 
 // heavily inspired by dwm.c
@@ -853,7 +916,7 @@ void client_update_wm_hints(HSClient* client) {
             snprintf(winid_str, STRING_BUF_SIZE, "0x%lx", client->window);
             client_setup_border(client, focused_client == client);
             hook_emit_list("urgent", client->urgent ? "on":"off", winid_str, NULL);
-            tag_set_flags_dirty();
+            tag_flags_update_urgent(client);
         }
     }
     if (wmh->flags & InputHint) {
@@ -864,6 +927,29 @@ void client_update_wm_hints(HSClient* client) {
     XFree(wmh);
 }
 
+void client_update_class(HSClient* client) {
+    if (client->window_class) {
+        g_string_free(client->window_class, true);
+    }
+    if (client->window_instance) {
+        g_string_free(client->window_instance, true);
+    }
+    window_class_hint_to_g_strings(g_display, client->window,
+        &client->window_class, &client->window_instance);
+}
+
+void client_update_window_role(HSClient* client) {
+    if (client->window_role) {
+        g_string_free(client->window_role, true);
+    }
+    client->window_role = window_property_to_g_string(g_display,
+        client->window, ATOM("WM_WINDOW_ROLE"));
+}
+
+void client_update_window_type(HSClient* client) {
+    client->window_type = ewmh_get_window_type(client->window);
+}
+
 void client_update_title(HSClient* client) {
     GString* new_name = window_property_to_g_string(g_display,
         client->window, g_netatom[NetWmName]);
@@ -894,7 +980,14 @@ void client_update_title(HSClient* client) {
     if (changed && get_current_client() == client) {
         char buf[STRING_BUF_SIZE];
         snprintf(buf, STRING_BUF_SIZE, "0x%lx", client->window);
-        hook_emit_list("window_title_changed", buf, client->title->str, NULL);
+        const char* argv[] = { "window_title_changed", buf, client->title->str };
+        // a pending focus_changed carries an older title, so it has to be
+        // emitted before
+        hook_flush_coalesced_key("focus_changed");
+        // coalesce the title changes of each client separately
+        char key[STRING_BUF_SIZE];
+        client_title_hook_key(client, key);
+        hook_emit_coalesced(key, LENGTH(argv), argv);
     }
 }
 
@@ -25,10 +25,18 @@ typedef struct HSClient {
     GString*    window_str;     // the window id as a string
     Rectangle   last_size;      // last size excluding the window border
     HSTag*      tag;
+    struct HSFrame* frame;      // the frame containing the client or NULL
     Rectangle   float_size;     // floating size without the window border
     GString*    title;  // or also called window title; this is never NULL
     GString*    keymask; // keymask applied to mask out keybindins
+    // cached window properties, updated on property changes. They are never
+    // NULL, except window_role which is NULL if the window has no role
+    GString*    window_class;
+    GString*    window_instance;
+    GString*    window_role;
+    int         window_type; // element of the NetWm-Enum or -1
     bool        urgent;
+    bool        urgent_counted; // urgent as counted by the tag flags
     bool        fullscreen;
     bool        ewmhfullscreen; // ewmh fullscreen state
     bool        pseudotile; // only move client but don't resize (if possible)
@@ -69,8 +77,11 @@ void client_window_unfocus_last();
 void reset_client_colors();
 void reset_client_settings();
 
-// adds a new client to list of managed client windows
-HSClient* manage_client(Window win, bool force_unmanage = false);
+// adds a new client to list of managed client windows. If the caller already
+// fetched the window attributes, they are used instead of asking the server
+// for the geometry again
+HSClient* manage_client(Window win, bool force_unmanage = false,
+                        const XWindowAttributes* window_attributes = NULL);
 void client_fuzzy_fix_initial_position(HSClient* client);
 void unmanage_client(Window win);
 
@@ -79,6 +90,10 @@ void window_enforce_last_size(Window in);
 // destroys a special client
 void client_destroy(HSClient* client);
 
+void client_update_class(HSClient* client);
+void client_update_window_role(HSClient* client);
+void client_update_window_type(HSClient* client);
+
 HSClient* get_client_from_window(Window window);
 HSClient* get_current_client();
 HSClient* get_urgent_client();
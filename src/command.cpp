@@ -14,6 +14,7 @@
 #include "rules.h"
 #include "object.h"
 #include "mouse.h"
+#include "profile.h"
 
 #include "glib-backports.h"
 #include <string.h>
@@ -24,6 +25,8 @@
 
 extern char** environ;
 
+static GHashTable* g_command_table; // command name -> CommandBinding*
+
 // if the current completion needs shell quoting and other shell specific
 // behaviour
 static bool g_shell_quoting = false;
@@ -39,6 +42,7 @@ static const char* completion_special_winids[]= { "urgent", "", NULL };
 static const char* completion_use_index_args[]= { "--skip-visible", NULL };
 static const char* completion_cycle_all_args[]= { "--skip-invisible", NULL };
 static const char* completion_pm_one[]= { "+1", "-1", NULL };
+static const char* completion_profile_args[]= { "reset", "dump", NULL };
 static const char* completion_mouse_functions[]= { "move", "zoom", "resize", "call", NULL };
 static const char* completion_detect_monitors_args[] =
     { "const -l", "--list", "--no-disjoin", /* TODO: "--keep-small", */ NULL };
@@ -79,6 +83,7 @@ struct {
     { "try",            2,  parameter_expected_offset_1 },
     { "silent",         2,  parameter_expected_offset_1 },
     { "version",        1,  no_completion },
+    { "profile",        2,  no_completion },
     { "list_commands",  1,  no_completion },
     { "list_monitors",  1,  no_completion },
     { "list_keybinds",  1,  no_completion },
@@ -215,6 +220,7 @@ struct {
     { "try",            GE, 1,  complete_against_commands_1, 0 },
     { "silent",         GE, 1,  complete_against_commands_1, 0 },
     { "pseudotile",     EQ, 1,  NULL, completion_flag_args },
+    { "profile",        EQ, 1,  NULL, completion_profile_args },
     { "keybind",        GE, 1,  complete_against_keybind_command, 0 },
     { "keyunbind",      EQ, 1,  NULL, completion_keyunbind_args },
     { "keyunbind",      EQ, 1,  complete_against_keybinds, 0 },
@@ -291,19 +297,34 @@ struct {
     { 0 },
 };
 
+void command_init() {
+    g_command_table = g_hash_table_new(g_str_hash, g_str_equal);
+    for (int i = 0; g_commands[i].cmd.standard != NULL; i++) {
+        g_hash_table_insert(g_command_table,
+                            (gpointer)g_commands[i].name, g_commands + i);
+    }
+}
+
+void command_destroy() {
+    g_hash_table_destroy(g_command_table);
+    g_command_table = NULL;
+}
+
+CommandBinding* find_command(const char* name) {
+    return (CommandBinding*)g_hash_table_lookup(g_command_table, name);
+}
+
 int call_command(int argc, char** argv, GString* output) {
     if (argc <= 0) {
         return HERBST_COMMAND_NOT_FOUND;
     }
-    int i = 0;
-    CommandBinding* bind = NULL;
-    while (g_commands[i].cmd.standard != NULL) {
-        if (!strcmp(g_commands[i].name, argv[0])) {
-            // if command was found
-            bind = g_commands + i;
-            break;
-        }
-        i++;
+    return call_command_binding(find_command(argv[0]), argc, argv, output);
+}
+
+int call_command_binding(CommandBinding* bind,
+                         int argc, char** argv, GString* output) {
+    if (argc <= 0) {
+        return HERBST_COMMAND_NOT_FOUND;
     }
     if (!bind) {
         g_string_append_printf(output,
@@ -311,12 +332,14 @@ int call_command(int argc, char** argv, GString* output) {
         return HERBST_COMMAND_NOT_FOUND;
     }
     int status;
+    HSProfileStart start = profile_begin();
     // TODO why isn't the cast (char** -> const char**) done automtically?
     if (bind->has_output) {
         status = bind->cmd.standard(argc, (const char**)argv, output);
     } else {
         status = bind->cmd.no_output(argc, (const char**)argv);
     }
+    profile_end_command(bind->name, start);
     return status;
 }
 
@@ -41,7 +41,15 @@ typedef struct CommandBinding {
 
 extern CommandBinding g_commands[];
 
+void command_init();
+void command_destroy();
+
+// returns the command with the given name or NULL
+CommandBinding* find_command(const char* name);
 int call_command(int argc, char** argv, GString* output);
+// calls an already resolved command, bind may be NULL if argv[0] is unknown
+int call_command_binding(CommandBinding* bind,
+                         int argc, char** argv, GString* output);
 int call_command_no_output(int argc, char** argv);
 int call_command_substitute(char* needle, char* replacement,
                             int argc, char** argv, GString* output);
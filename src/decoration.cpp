@@ -4,6 +4,8 @@
 #include "globals.h"
 #include "settings.h"
 #include "ewmh.h"
+#include "profile.h"
+#include "mouse.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -32,6 +34,10 @@ static GString* PROP2MEMBERS(HSAttribute* attr);
 
 // is called automatically after resize_outline
 static void decoration_update_frame_extents(struct HSClient* client);
+static bool decoration_scheme_equals(HSDecorationScheme* a, HSDecorationScheme* b);
+
+unsigned int g_decoration_configure_count = 0;
+unsigned int g_decoration_configure_elided_count = 0;
 
 void decorations_init() {
     g_theme_object = hsobject_create_and_link(hsobject_root(), "theme");
@@ -376,6 +382,7 @@ void decoration_resize_inner(HSClient* client, Rectangle inner,
 void decoration_resize_outline(HSClient* client, Rectangle outline,
                                HSDecorationScheme scheme)
 {
+    HSProfileStart start = profile_begin();
     Rectangle inner = outline_to_inner_rect(outline, scheme);
     // get relative coordinates
     Window decwin = client->dec.decwin;
@@ -394,14 +401,40 @@ void decoration_resize_outline(HSClient* client, Rectangle outline,
         inner.y = tile.y + ((dy < threshold) ? 0 : dy);
     }
 
-    //if (RECTANGLE_EQUALS(client->last_size, rect)
-    //    && client->last_border_width == border_width) {
-    //    return;
-    //}
-
     if (scheme.tight_decoration) {
         outline = inner_rect_to_outline(inner, scheme);
     }
+    bool applied = !client->dragged || *g_update_dragged_clients;
+    if (applied && client->dec.last_geometry_applied && !client->dec.deferred
+        && RECTANGLE_EQUALS(client->dec.last_inner_rect, inner)
+        && RECTANGLE_EQUALS(client->dec.last_outer_rect, outline)
+        && decoration_scheme_equals(&client->dec.last_scheme, &scheme)) {
+        // the X server already has exactly this state
+        client->dec.last_rect_inner = false;
+        g_decoration_configure_elided_count++;
+        profile_end(g_profile_resize_outline, start);
+        return;
+    }
+    g_decoration_configure_count++;
+    // the pixmap only depends on the scheme, the sizes and the rectangles
+    // relative to the decoration, so a move does not need a redraw
+    Rectangle rel_inner = inner;
+    rel_inner.x -= outline.x;
+    rel_inner.y -= outline.y;
+    Rectangle last_rel_inner = client->dec.last_inner_rect;
+    last_rel_inner.x -= client->dec.last_outer_rect.x;
+    last_rel_inner.y -= client->dec.last_outer_rect.y;
+    bool size_changed = outline.width != client->dec.last_outer_rect.width
+                     || outline.height != client->dec.last_outer_rect.height;
+    bool redraw = client->dec.deferred || !client->dec.pixmap || size_changed
+        || !RECTANGLE_EQUALS(rel_inner, last_rel_inner)
+        || (applied && !RECTANGLE_EQUALS(rel_inner, client->dec.last_actual_rect))
+        || !decoration_scheme_equals(&client->dec.last_scheme, &scheme);
+    // during a drag, the geometry changes often, so the redraw and the
+    // configure event are done once it ends
+    bool defer = mouse_drag_affects(client);
+    client->dec.deferred = defer && (client->dec.deferred || redraw || applied);
+    client->dec.last_geometry_applied = applied;
     client->dec.last_inner_rect = inner;
     inner.x -= outline.x;
     inner.y -= outline.y;
@@ -425,27 +458,30 @@ void decoration_resize_outline(HSClient* client, Rectangle outline,
     //}
     // send new size to client
     // update structs
-    bool size_changed = outline.width != client->dec.last_outer_rect.width
-                     || outline.height != client->dec.last_outer_rect.height;
     client->dec.last_outer_rect = outline;
+    if (client->tag) {
+        rectindex_update(client->tag->rects, client);
+    }
     client->dec.last_rect_inner = false;
     client->last_size = inner;
     client->dec.last_scheme = scheme;
     // redraw
     // TODO: reduce flickering
-    if (!client->dragged || *g_update_dragged_clients) {
+    if (applied) {
         client->dec.last_actual_rect.x = changes.x;
         client->dec.last_actual_rect.y = changes.y;
         client->dec.last_actual_rect.width = changes.width;
         client->dec.last_actual_rect.height = changes.height;
     }
-    decoration_redraw_pixmap(client);
-    XSetWindowBackgroundPixmap(g_display, decwin, client->dec.pixmap);
-    if (!size_changed) {
-        // if size changes, then the window is cleared automatically
-        XClearWindow(g_display, decwin);
+    if (redraw && !defer) {
+        decoration_redraw_pixmap(client);
+        XSetWindowBackgroundPixmap(g_display, decwin, client->dec.pixmap);
+        if (!size_changed) {
+            // if size changes, then the window is cleared automatically
+            XClearWindow(g_display, decwin);
+        }
     }
-    if (!client->dragged || *g_update_dragged_clients) {
+    if (applied) {
         XConfigureWindow(g_display, win, mask, &changes);
         XMoveResizeWindow(g_display, client->dec.bgwin,
                           changes.x, changes.y,
@@ -454,10 +490,27 @@ void decoration_resize_outline(HSClient* client, Rectangle outline,
     XMoveResizeWindow(g_display, decwin,
                       outline.x, outline.y, outline.width, outline.height);
     decoration_update_frame_extents(client);
-    if (!client->dragged || *g_update_dragged_clients) {
+    if (applied && !defer) {
         client_send_configure(client);
     }
-    XSync(g_display, False);
+    // no XSync() here: the requests are flushed by the main loop, and a
+    // layout pass syncs only once in drop_enternotify_events()
+    profile_end(g_profile_resize_outline, start);
+}
+
+static bool decoration_scheme_equals(HSDecorationScheme* a, HSDecorationScheme* b) {
+    return a->border_width == b->border_width
+        && a->border_color == b->border_color
+        && a->tight_decoration == b->tight_decoration
+        && a->inner_color == b->inner_color
+        && a->inner_width == b->inner_width
+        && a->outer_color == b->outer_color
+        && a->outer_width == b->outer_width
+        && a->padding_top == b->padding_top
+        && a->padding_right == b->padding_right
+        && a->padding_bottom == b->padding_bottom
+        && a->padding_left == b->padding_left
+        && a->background_color == b->background_color;
 }
 
 static void decoration_update_frame_extents(struct HSClient* client) {
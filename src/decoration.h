@@ -44,6 +44,10 @@ typedef struct {
     Rectangle               last_inner_rect; // only valid if width >= 0
     Rectangle               last_outer_rect; // only valid if width >= 0
     Rectangle               last_actual_rect; // last actual client rect, relative to decoration
+    bool                    last_geometry_applied; // if the last_* geometry
+                                  // and scheme were fully sent to the X server
+    bool                    deferred; // if the pixmap redraw or the configure
+                                  // event was deferred until the drag ends
     /* X specific things */
     Colormap                colormap;
     unsigned int            depth;
@@ -77,6 +81,11 @@ enum {
 
 extern HSDecTriple g_decorations[];
 
+// number of client resizes sent to the X server and of those that were
+// skipped because neither geometry nor scheme changed
+extern unsigned int g_decoration_configure_count;
+extern unsigned int g_decoration_configure_elided_count;
+
 void decorations_init();
 void decorations_destroy();
 
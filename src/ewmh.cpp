@@ -27,8 +27,15 @@
 Atom g_netatom[NetCOUNT];
 
 // module internal globals:
-static Window*     g_windows; // array with Window-IDs
-static size_t      g_window_count;
+static Window*     g_windows; // array with Window-IDs in mapping order, removed
+                              // windows are None until the next compaction
+static size_t      g_windows_used; // number of used slots in g_windows
+static size_t      g_windows_capacity;
+static size_t      g_window_count; // number of windows in g_windows
+static GHashTable* g_window_indices; // maps a Window to its index + 1
+static bool        g_client_list_dirty;
+static bool        g_client_list_stacking_dirty;
+static GArray*     g_stacking; // buffer for _NET_CLIENT_LIST_STACKING
 static Window      g_wm_window;
 static int*        g_focus_stealing_prevention;
 
@@ -83,14 +90,24 @@ void ewmh_init() {
     g_focus_stealing_prevention =
         &(settings_find("focus_stealing_prevention")->value.i);
 
-    /* init ewmh net atoms */
+    /* init ewmh net atoms, all of them in one request */
+    char* names[NetCOUNT];
+    int indices[NetCOUNT];
+    Atom atoms[NetCOUNT];
+    int count = 0;
     for (int i = 0; i < NetCOUNT; i++) {
         if (g_netatom_names[i] == NULL) {
             g_warning("no name specified in g_netatom_names "
                       "for atom number %d\n", i);
             continue;
         }
-        g_netatom[i] = XInternAtom(g_display, g_netatom_names[i], False);
+        names[count] = (char*)g_netatom_names[i];
+        indices[count] = i;
+        count++;
+    }
+    XInternAtoms(g_display, names, count, False, atoms);
+    for (int i = 0; i < count; i++) {
+        g_netatom[indices[i]] = atoms[i];
     }
 
     /* tell which ewmh atoms are supported */
@@ -99,7 +116,13 @@ void ewmh_init() {
 
     /* init some globals */
     g_windows = NULL;
+    g_windows_used = 0;
+    g_windows_capacity = 0;
     g_window_count = 0;
+    g_window_indices = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_client_list_dirty = false;
+    g_client_list_stacking_dirty = false;
+    g_stacking = g_array_new(false, false, sizeof(Window));
     if (!ewmh_read_client_list(&g_original_clients, &g_original_clients_count))
     {
         g_original_clients = NULL;
@@ -107,7 +130,7 @@ void ewmh_init() {
     }
 
     /* init other atoms */
-    WM_STATE = XInternAtom(g_display, "WM_STATE", False);
+    WM_STATE = ATOM("WM_STATE");
 
     /* init for the supporting wm check */
     g_wm_window = XCreateSimpleWindow(g_display, g_root,
@@ -128,6 +151,7 @@ void ewmh_update_all() {
     /* init many properties */
     ewmh_update_client_list();
     ewmh_update_client_list_stacking();
+    ewmh_flush_client_lists();
     ewmh_update_desktops();
     ewmh_update_current_desktop();
     ewmh_update_desktop_names();
@@ -135,6 +159,8 @@ void ewmh_update_all() {
 
 void ewmh_destroy() {
     g_free(g_windows);
+    g_array_free(g_stacking, true);
+    g_hash_table_destroy(g_window_indices);
     if (g_original_clients) {
         XFree(g_original_clients);
     }
@@ -156,6 +182,31 @@ void ewmh_update_wmname() {
 }
 
 void ewmh_update_client_list() {
+    g_client_list_dirty = true;
+}
+
+// removes the gaps of removed windows from g_windows
+static void ewmh_compact_windows() {
+    size_t j = 0;
+    for (size_t i = 0; i < g_windows_used; i++) {
+        if (g_windows[i] == None) {
+            continue;
+        }
+        if (i != j) {
+            g_windows[j] = g_windows[i];
+            g_hash_table_insert(g_window_indices,
+                                GSIZE_TO_POINTER(g_windows[j]),
+                                GSIZE_TO_POINTER(j + 1));
+        }
+        j++;
+    }
+    g_windows_used = j;
+}
+
+static void ewmh_write_client_list() {
+    if (g_windows_used != g_window_count) {
+        ewmh_compact_windows();
+    }
     XChangeProperty(g_display, g_root, g_netatom[NetClientList],
         XA_WINDOW, 32, PropModeReplace,
         (unsigned char *) g_windows, g_window_count);
@@ -181,67 +232,71 @@ void ewmh_get_original_client_list(Window** buf, unsigned long *count) {
     *count = g_original_clients_count;
 }
 
-struct ewmhstack {
-    Window* buf;
-    int     count;
-    int     i;  // index of the next free element in buf
-};
-
 static void ewmh_add_tag_stack(HSTag* tag, void* data) {
-    struct ewmhstack* stack = (struct ewmhstack*)data;
+    GArray* stacking = (GArray*)data;
     if (find_monitor_with_tag(tag)) {
         // do not add tags because they are already added
         return;
     }
-    int remain;
-    stack_to_window_buf(tag->stack, stack->buf + stack->i,
-                        stack->count - stack->i, true, &remain);
-    if (remain >= 0) {
-        stack->i = stack->count - remain;
-    } else {
-        HSDebug("Warning: not enough space in the ewmh stack\n");
-        stack->i = stack->count;
-    }
+    stack_append_windows(tag->stack, stacking, true);
 }
 
 void ewmh_update_client_list_stacking() {
+    g_client_list_stacking_dirty = true;
+}
+
+static void ewmh_write_client_list_stacking() {
     // First: get the windows in the current stack
-    struct ewmhstack stack;
-    stack.count = g_window_count;
-    stack.buf = g_new(Window, stack.count);
-    int remain;
-    monitor_stack_to_window_buf(stack.buf, stack.count, true, &remain);
-    stack.i = stack.count - remain;
+    g_array_set_size(g_stacking, 0);
+    monitor_stack_append_windows(g_stacking, true);
 
     // Then add all the others at the end
-    tag_foreach(ewmh_add_tag_stack, &stack);
+    tag_foreach(ewmh_add_tag_stack, g_stacking);
 
     // reverse stacking order, because ewmh requires bottom to top order
-    array_reverse(stack.buf, stack.count, sizeof(stack.buf[0]));
+    Window* buf = &g_array_index(g_stacking, Window, 0);
+    array_reverse(buf, g_stacking->len, sizeof(buf[0]));
 
     XChangeProperty(g_display, g_root, g_netatom[NetClientListStacking],
         XA_WINDOW, 32, PropModeReplace,
-        (unsigned char *) stack.buf, stack.i);
-    g_free(stack.buf);
+        (unsigned char *) buf, g_stacking->len);
+}
+
+void ewmh_flush_client_lists() {
+    if (g_client_list_dirty) {
+        ewmh_write_client_list();
+        g_client_list_dirty = false;
+    }
+    if (g_client_list_stacking_dirty) {
+        ewmh_write_client_list_stacking();
+        g_client_list_stacking_dirty = false;
+    }
 }
 
 void ewmh_add_client(Window win) {
-    g_windows = g_renew(Window, g_windows, g_window_count + 1);
-    g_windows[g_window_count] = win;
+    if (g_windows_used == g_windows_capacity) {
+        g_windows_capacity = MAX(16, 2 * g_windows_capacity);
+        g_windows = g_renew(Window, g_windows, g_windows_capacity);
+    }
+    g_windows[g_windows_used] = win;
+    g_windows_used++;
+    g_hash_table_insert(g_window_indices, GSIZE_TO_POINTER(win),
+                        GSIZE_TO_POINTER(g_windows_used));
     g_window_count++;
     ewmh_update_client_list();
     ewmh_update_client_list_stacking();
 }
 
 void ewmh_remove_client(Window win) {
-    int index = array_find(g_windows, g_window_count,
-                           sizeof(Window), &win);
-    if (index < 0) {
+    gsize index = GPOINTER_TO_SIZE(
+        g_hash_table_lookup(g_window_indices, GSIZE_TO_POINTER(win)));
+    if (index == 0) {
         g_warning("could not find window %lx in g_windows\n", win);
     } else {
-        g_memmove(g_windows + index, g_windows + index + 1,
-                  sizeof(Window) *(g_window_count - index - 1));
-        g_windows = g_renew(Window, g_windows, g_window_count - 1);
+        // leave a gap to keep the mapping order, it is removed before the
+        // property is written
+        g_windows[index - 1] = None;
+        g_hash_table_remove(g_window_indices, GSIZE_TO_POINTER(win));
         g_window_count--;
     }
     ewmh_update_client_list();
@@ -414,12 +469,12 @@ void ewmh_handle_client_message(XEvent* event) {
             int direction = me->data.l[2];
             if (direction == _NET_WM_MOVERESIZE_MOVE
                 || direction == _NET_WM_MOVERESIZE_MOVE_KEYBOARD) {
-                mouse_initiate_move(client, 0, NULL);
+                mouse_initiate_move(client, NULL);
             } else if (direction == _NET_WM_MOVERESIZE_CANCEL) {
                 if (mouse_is_dragging()) mouse_stop_drag();
             } else {
                 // anything else is a resize
-                mouse_initiate_resize(client, 0, NULL);
+                mouse_initiate_resize(client, NULL);
             }
             break;
         }
@@ -90,9 +90,12 @@ void ewmh_remove_client(Window win);
 void ewmh_set_wmname(char* name);
 void ewmh_update_wmname();
 
+// the client lists are only marked as changed, the root window properties
+// are written by ewmh_flush_client_lists() once per event loop iteration
 void ewmh_update_client_list();
 void ewmh_get_original_client_list(Window** buf, unsigned long *count);
 void ewmh_update_client_list_stacking();
+void ewmh_flush_client_lists();
 void ewmh_update_desktops();
 void ewmh_update_desktop_names();
 void ewmh_update_active_window(Window win);
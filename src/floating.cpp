@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <assert.h>
 
 #include "utils.h"
 #include "mouse.h"
@@ -10,6 +11,7 @@
 #include "tag.h"
 #include "layout.h"
 #include "settings.h"
+#include "monitor.h"
 
 static int* g_snap_gap;
 static int* g_monitors_locked;
@@ -216,115 +218,291 @@ int find_edge_right_of(RectangleIdx* rects, size_t cnt, int idx) {
 }
 
 
-static int collectclients_helper(HSClient* client, void* data) {
-    GQueue* q = (GQueue*)data;
-    g_queue_push_tail(q, client);
-    return 0;
+static int rectangle_edge(Rectangle r, int edge) {
+    switch (edge) {
+        case RECT_EDGE_LEFT:    return r.x;
+        case RECT_EDGE_RIGHT:   return r.x + r.width;
+        case RECT_EDGE_TOP:     return r.y;
+        case RECT_EDGE_BOTTOM:  return r.y + r.height;
+        case RECT_CENTER_X:     return r.x + r.width / 2;
+        default:                return r.y + r.height / 2;
+    }
+}
+
+// returns the first position in the edge array whose item is not before the
+// given key and sequence number
+static size_t rectindex_lower_bound(HSRectIndex* index, int edge,
+                                    int key, unsigned int seq) {
+    GArray* a = index->edges[edge];
+    size_t low = 0;
+    size_t high = a->len;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        HSRectIndexItem* item = g_array_index(a, HSRectIndexItem*, mid);
+        int k = rectangle_edge(item->rect, edge);
+        if (k < key || (k == key && item->seq < seq)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void rectindex_link(HSRectIndex* index, HSRectIndexItem* item,
+                           int edge, int key) {
+    size_t pos = rectindex_lower_bound(index, edge, key, item->seq);
+    g_array_insert_val(index->edges[edge], pos, item);
+}
+
+static void rectindex_unlink(HSRectIndex* index, HSRectIndexItem* item,
+                             int edge, int key) {
+    size_t pos = rectindex_lower_bound(index, edge, key, item->seq);
+    assert(g_array_index(index->edges[edge], HSRectIndexItem*, pos) == item);
+    g_array_remove_index(index->edges[edge], pos);
+}
+
+HSRectIndex* rectindex_create() {
+    HSRectIndex* index = g_new0(HSRectIndex, 1);
+    FOR (i,0,RECT_EDGE_COUNT) {
+        index->edges[i] = g_array_new(false, false, sizeof(HSRectIndexItem*));
+    }
+    index->items = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, g_free);
+    return index;
+}
+
+void rectindex_destroy(HSRectIndex* index) {
+    FOR (i,0,RECT_EDGE_COUNT) {
+        g_array_free(index->edges[i], true);
+    }
+    g_hash_table_destroy(index->items);
+    g_free(index);
+}
+
+void rectindex_insert(HSRectIndex* index, HSClient* client) {
+    HSRectIndexItem* item = g_new0(HSRectIndexItem, 1);
+    item->client = client;
+    item->rect = client->dec.last_outer_rect;
+    item->seq = index->next_seq++;
+    FOR (i,0,RECT_EDGE_COUNT) {
+        rectindex_link(index, item, i, rectangle_edge(item->rect, i));
+    }
+    g_hash_table_insert(index->items, client, item);
+}
+
+void rectindex_remove(HSRectIndex* index, HSClient* client) {
+    HSRectIndexItem* item =
+        (HSRectIndexItem*)g_hash_table_lookup(index->items, client);
+    if (!item) {
+        return;
+    }
+    FOR (i,0,RECT_EDGE_COUNT) {
+        rectindex_unlink(index, item, i, rectangle_edge(item->rect, i));
+    }
+    g_hash_table_remove(index->items, client);
+}
+
+void rectindex_update(HSRectIndex* index, HSClient* client) {
+    HSRectIndexItem* item =
+        (HSRectIndexItem*)g_hash_table_lookup(index->items, client);
+    if (!item || RECTANGLE_EQUALS(item->rect, client->dec.last_outer_rect)) {
+        return;
+    }
+    Rectangle rect = client->dec.last_outer_rect;
+    // only move the item in the arrays of the edges that changed
+    FOR (i,0,RECT_EDGE_COUNT) {
+        int old_key = rectangle_edge(item->rect, i);
+        int new_key = rectangle_edge(rect, i);
+        if (old_key != new_key) {
+            rectindex_unlink(index, item, i, old_key);
+            rectindex_link(index, item, i, new_key);
+        }
+    }
+    item->rect = rect;
+}
+
+void rectindex_foreach_in_range(HSRectIndex* index, enum HSRectEdge edge,
+                                int low, int high,
+                                int (*action)(HSClient*, void*),
+                                void* data) {
+    GArray* a = index->edges[edge];
+    for (size_t i = rectindex_lower_bound(index, edge, low, 0); i < a->len; i++) {
+        HSRectIndexItem* item = g_array_index(a, HSRectIndexItem*, i);
+        if (rectangle_edge(item->rect, edge) > high) {
+            break;
+        }
+        action(item->client, data);
+    }
+}
+
+HSClient* rectindex_find_in_direction(HSRectIndex* index, HSClient* client,
+                                      enum HSDirection dir) {
+    HSRectIndexItem* from =
+        (HSRectIndexItem*)g_hash_table_lookup(index->items, client);
+    if (!from) {
+        return NULL;
+    }
+    bool vertical = (dir == DirUp || dir == DirDown);
+    // if we go backwards, then rectangles with the same distance are
+    // considered in the reverse order
+    bool backwards = (dir == DirLeft || dir == DirUp);
+    int axis = vertical ? RECT_CENTER_Y : RECT_CENTER_X;
+    int other_axis = vertical ? RECT_CENTER_X : RECT_CENTER_Y;
+    int c = rectangle_edge(from->rect, axis);
+    int c_other = rectangle_edge(from->rect, other_axis);
+    // rectangles with the same center and an earlier position in the
+    // direction are not considered, exactly like in find_rectangle_right_of()
+    GArray* a = index->edges[axis];
+    size_t i = rectindex_lower_bound(index, axis, c, from->seq);
+    HSRectIndexItem* best = NULL;
+    int distbest = INT_MAX;
+    while (backwards ? (i > 0) : (i + 1 < a->len)) {
+        i = backwards ? (i - 1) : (i + 1);
+        HSRectIndexItem* item = g_array_index(a, HSRectIndexItem*, i);
+        int dist_axis = abs(rectangle_edge(item->rect, axis) - c);
+        if (dist_axis > distbest) {
+            // all remaining rectangles are even farther away
+            break;
+        }
+        int dist_other = abs(rectangle_edge(item->rect, other_axis) - c_other);
+        if (dist_other > dist_axis) {
+            // not in the 90 degree cone in direction dir
+            continue;
+        }
+        int dist = dist_axis + dist_other;
+        if (dist < distbest
+            || (dist == distbest
+                && (backwards ? item->seq > best->seq : item->seq < best->seq))) {
+            distbest = dist;
+            best = item;
+        }
+    }
+    return best ? best->client : NULL;
+}
+
+bool rectindex_find_edge(HSRectIndex* index, HSClient* client,
+                         int gap, enum HSDirection dir, int* edge) {
+    HSRectIndexItem* from =
+        (HSRectIndexItem*)g_hash_table_lookup(index->items, client);
+    if (!from) {
+        return false;
+    }
+    // both rectangles are expanded by the gap. They have to overlap
+    // orthogonal to the direction, and the edge of the other has to be
+    // strictly behind the edge of the client in the direction
+    Rectangle r = from->rect;
+    bool vertical = (dir == DirUp || dir == DirDown);
+    bool backwards = (dir == DirLeft || dir == DirUp);
+    int pos = vertical ? r.y : r.x;
+    int size = vertical ? r.height : r.width;
+    int other_pos = vertical ? r.x : r.y;
+    int other_size = vertical ? r.width : r.height;
+    int edge_type;
+    size_t i;
+    // the edges before i are in direction dir if backwards, otherwise the
+    // ones starting at i
+    if (backwards) {
+        edge_type = vertical ? RECT_EDGE_BOTTOM : RECT_EDGE_RIGHT;
+        i = rectindex_lower_bound(index, edge_type, pos - 2 * gap, 0);
+    } else {
+        edge_type = vertical ? RECT_EDGE_TOP : RECT_EDGE_LEFT;
+        i = rectindex_lower_bound(index, edge_type, pos + size + 2 * gap + 1, 0);
+    }
+    GArray* a = index->edges[edge_type];
+    size_t count = backwards ? i : (a->len - i);
+    // the first overlapping rectangle in the direction is the nearest one
+    for (size_t n = 0; n < count; n++) {
+        size_t j = backwards ? (i - 1 - n) : (i + n);
+        HSRectIndexItem* item = g_array_index(a, HSRectIndexItem*, j);
+        if (item == from) {
+            continue;
+        }
+        Rectangle o = item->rect;
+        int low = vertical ? o.x : o.y;
+        int high = low + (vertical ? o.width : o.height);
+        if (!intervals_intersect(other_pos - gap, other_pos + other_size + gap,
+                                 low - gap, high + gap)) {
+            continue;
+        }
+        int key = rectangle_edge(item->rect, edge_type);
+        *edge = backwards ? (key + gap) : (key - gap);
+        return true;
+    }
+    return false;
 }
 
 bool floating_focus_direction(enum HSDirection dir) {
     if (*g_monitors_locked) { return false; }
+    monitors_apply_dirty_layouts(); // ensure last_outer_rect is up to date
     HSTag* tag = g_cur_frame->tag;
-    GQueue* q = g_queue_new();
-    frame_foreach_client(tag->frame, collectclients_helper, q);
-    int cnt = q->length;
-    RectangleIdx* rects = g_new0(RectangleIdx, cnt);
-    int i = 0;
-    int curfocusidx = -1;
     HSClient* curfocus = get_current_client();
-    bool success = true;
-    if (curfocus == NULL && cnt == 0) {
-        success = false;
-    }
-    for (GList* cur = q->head; cur != NULL; cur = cur->next, i++) {
-        HSClient* client = (HSClient*)cur->data;
-        if (curfocus == client) curfocusidx = i;
-        rects[i].idx = i;
-        rects[i].r = client->dec.last_outer_rect;
+    if (!curfocus) {
+        return false;
     }
-    int idx = (cnt > 0)
-              ? find_rectangle_in_direction(rects, cnt, curfocusidx, dir)
-              : -1;
-    if (idx < 0) {
-        success = false;
-    } else {
-        HSClient* client = (HSClient*)g_queue_peek_nth(q, idx);
-        client_raise(client);
-        focus_client(client, false, false);
+    HSClient* client = rectindex_find_in_direction(tag->rects, curfocus, dir);
+    if (!client) {
+        return false;
     }
-    g_free(rects);
-    g_queue_free(q);
-    return success;
+    client_raise(client);
+    focus_client(client, false, false);
+    return true;
 }
 
 bool floating_shift_direction(enum HSDirection dir) {
     if (*g_monitors_locked) { return false; }
+    monitors_apply_dirty_layouts(); // ensure last_outer_rect is up to date
     HSTag* tag = g_cur_frame->tag;
     HSClient* curfocus = get_current_client();
     if (!curfocus) return false;
-    GQueue* q = g_queue_new();
-    frame_foreach_client(tag->frame, collectclients_helper, q);
-    int cnt = q->length;
-    if (cnt == 0) {
-        g_queue_free(q);
-        return false;
-    }
-    RectangleIdx* rects = g_new0(RectangleIdx, cnt + 4);
-    int i = 0;
-    int curfocusidx = -1;
-    bool success = true;
-    for (GList* cur = q->head; cur != NULL; cur = cur->next, i++) {
-        HSClient* client = (HSClient*)cur->data;
-        if (curfocus == client) curfocusidx = i;
-        rects[i].idx = i;
-        rects[i].r = client->dec.last_outer_rect;
-    }
-    g_queue_free(q);
-    // add artifical rects for screen edges
-    {
-        Rectangle mr = monitor_get_floating_area(get_current_monitor());
-        Rectangle tmp[4] = {
-            { mr.x, mr.y,               mr.width, 0 }, // top
-            { mr.x, mr.y,               0, mr.height }, // left
-            { mr.x + mr.width, mr.y,    0, mr.height }, // right
-            { mr.x, mr.y + mr.height,   mr.y + mr.width, 0 }, // bottom
-        };
-        FOR (i,0,4) {
-            rects[cnt + i].idx = -1;
-            rects[cnt + i].r = tmp[i];
-        }
-    }
-    FOR (i,0, cnt + 4) {
+    Rectangle focusrect = curfocus->dec.last_outer_rect;
+    bool vertical = (dir == DirUp || dir == DirDown);
+    bool backwards = (dir == DirLeft || dir == DirUp);
+    int edge;
+    bool found = rectindex_find_edge(tag->rects, curfocus, *g_snap_gap, dir, &edge);
+    // the focused client and artifical rects for screen edges
+    Rectangle mr = monitor_get_floating_area(get_current_monitor());
+    RectangleIdx rects[5] = {
+        { focusrect, 0 },
+        { { mr.x, mr.y,               mr.width, 0 }, -1 }, // top
+        { { mr.x, mr.y,               0, mr.height }, -1 }, // left
+        { { mr.x + mr.width, mr.y,    0, mr.height }, -1 }, // right
+        { { mr.x, mr.y + mr.height,   mr.y + mr.width, 0 }, -1 }, // bottom
+    };
+    FOR (i,0,LENGTH(rects)) {
         // expand anything by the snap gap
         rects[i].r.x -= *g_snap_gap;
         rects[i].r.y -= *g_snap_gap;
         rects[i].r.width += 2 * *g_snap_gap;
         rects[i].r.height += 2 * *g_snap_gap;
     }
-    // don't apply snapgap to focused client, so there will be exactly
-    // *g_snap_gap pixels between the focused client and the found edge
-    Rectangle focusrect = curfocus->dec.last_outer_rect;
-    int idx = find_edge_in_direction(rects, cnt + 4, curfocusidx, dir);
-    if (idx < 0) success = false;
-    else {
-        // shift client
-        int dx = 0, dy = 0;
+    int idx = find_edge_in_direction(rects, LENGTH(rects), 0, dir);
+    if (idx >= 0) {
+        // take the screen edge if it is nearer than all clients
         Rectangle r = rects[idx].r;
-        //printf("edge: %dx%d at %d,%d\n", r.width, r.height, r.x, r.y);
-        //printf("focus: %dx%d at %d,%d\n", focusrect.width, focusrect.height, focusrect.x, focusrect.y);
-        switch (dir) {
-            //          delta = new edge  -  old edge
-            case DirRight: dx = r.x  -   (focusrect.x + focusrect.width); break;
-            case DirLeft:  dx = r.x + r.width   -   focusrect.x; break;
-            case DirDown:  dy = r.y  -  (focusrect.y + focusrect.height); break;
-            case DirUp:    dy = r.y + r.height  -  focusrect.y; break;
+        int screen_edge = vertical ? r.y : r.x;
+        if (backwards) {
+            screen_edge += vertical ? r.height : r.width;
         }
-        //printf("dx=%d, dy=%d\n", dx, dy);
-        curfocus->float_size.x += dx;
-        curfocus->float_size.y += dy;
-        monitor_apply_layout(get_current_monitor());
+        if (!found || (backwards ? (screen_edge > edge) : (screen_edge < edge))) {
+            edge = screen_edge;
+        }
+        found = true;
+    }
+    if (!found) {
+        return false;
     }
-    g_free(rects);
-    return success;
+    // don't apply snapgap to focused client, so there will be exactly
+    // *g_snap_gap pixels between the focused client and the found edge
+    //          delta = new edge  -  old edge
+    int pos = vertical ? focusrect.y : focusrect.x;
+    int size = vertical ? focusrect.height : focusrect.width;
+    int delta = edge - (backwards ? pos : (pos + size));
+    if (vertical) {
+        curfocus->float_size.y += delta;
+    } else {
+        curfocus->float_size.x += delta;
+    }
+    monitor_apply_layout(get_current_monitor());
+    return true;
 }
-
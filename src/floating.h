@@ -8,8 +8,11 @@
 
 #include <sys/types.h>
 #include "x11-types.h"
+#include "glib-backports.h"
 #include <stdbool.h>
 
+struct HSClient;
+
 enum HSDirection {
     DirRight,
     DirLeft,
@@ -22,6 +25,30 @@ typedef struct {
     int       idx;
 } RectangleIdx;
 
+enum HSRectEdge {
+    RECT_EDGE_LEFT,
+    RECT_EDGE_RIGHT,
+    RECT_EDGE_TOP,
+    RECT_EDGE_BOTTOM,
+    RECT_CENTER_X,
+    RECT_CENTER_Y,
+    RECT_EDGE_COUNT,
+};
+
+typedef struct {
+    struct HSClient*    client;
+    Rectangle           rect;   // the outer rect of the client when indexed
+    unsigned int        seq;    // insertion order, orders equal positions
+} HSRectIndexItem;
+
+// the outer rects of the clients of a tag, sorted by each of their edges, such
+// that the neighbours of a client are found by a binary search
+typedef struct HSRectIndex {
+    GArray*         edges[RECT_EDGE_COUNT]; // HSRectIndexItem*, ascending
+    GHashTable*     items;  // maps a client to its HSRectIndexItem
+    unsigned int    next_seq;
+} HSRectIndex;
+
 void floating_init();
 void floating_destroy();
 
@@ -35,6 +62,28 @@ int find_edge_in_direction(RectangleIdx* rects, size_t cnt, int idx,
                                 enum HSDirection dir);
 int find_edge_right_of(RectangleIdx* rects, size_t cnt, int idx);
 
+HSRectIndex* rectindex_create();
+void rectindex_destroy(HSRectIndex* index);
+void rectindex_insert(HSRectIndex* index, struct HSClient* client);
+void rectindex_remove(HSRectIndex* index, struct HSClient* client);
+// re-sorts the client if its dec.last_outer_rect changed
+void rectindex_update(HSRectIndex* index, struct HSClient* client);
+// calls action for all clients whose edge is in the interval [low, high],
+// ordered by that edge. The action must not modify the index.
+void rectindex_foreach_in_range(HSRectIndex* index, enum HSRectEdge edge,
+                                int low, int high,
+                                int (*action)(struct HSClient*, void*),
+                                void* data);
+// the same as find_rectangle_in_direction() on the rects of all clients, but
+// clients with the same distance are ordered by the time they were inserted
+struct HSClient* rectindex_find_in_direction(HSRectIndex* index,
+                                struct HSClient* client, enum HSDirection dir);
+// finds the nearest edge of an other client in direction dir, such that the
+// client can be moved there while keeping the gap to it. The found edge already
+// includes the gap
+bool rectindex_find_edge(HSRectIndex* index, struct HSClient* client,
+                         int gap, enum HSDirection dir, int* edge);
+
 // actual implementations
 bool floating_focus_direction(enum HSDirection dir);
 bool floating_shift_direction(enum HSDirection dir);
@@ -7,6 +7,8 @@
 #include "globals.h"
 #include "utils.h"
 #include "ipc-protocol.h"
+#include "ipc-server.h"
+#include "settings.h"
 // std
 #include <assert.h>
 #include <stdio.h>
@@ -20,8 +22,42 @@
 #include <X11/Xatom.h>
 
 static Window g_event_window;
+static uint64_t g_hook_sequence = 0; // number of hooks emitted so far
+static int* g_hook_coalesce_interval;
+
+// the state of a coalescing key, it is dropped once its interval has passed
+// without further hooks
+typedef struct {
+    gint64  interval_end;   // monotonic time in microseconds
+    char**  pending;        // latest hook of the interval, not emitted yet
+} HSCoalescedHook;
+
+static GHashTable* g_coalesced_hooks; // maps keys to HSCoalescedHook*
+// the HSCoalescedHook* with a pending hook, in the order they were queued
+static GQueue* g_coalesced_pending;
+
+static void coalesced_hook_free(HSCoalescedHook* hook) {
+    if (hook->pending) {
+        g_queue_remove(g_coalesced_pending, hook);
+    }
+    g_strfreev(hook->pending);
+    g_free(hook);
+}
+
+// emits the pending hook now and starts a new interval
+static void coalesced_hook_emit_pending(HSCoalescedHook* hook, gint64 now) {
+    g_queue_remove(g_coalesced_pending, hook);
+    hook_emit(g_strv_length(hook->pending), (const char**)hook->pending);
+    g_strfreev(hook->pending);
+    hook->pending = NULL;
+    hook->interval_end = now + MAX(*g_hook_coalesce_interval, 0) * (gint64)1000;
+}
 
 void hook_init() {
+    g_hook_coalesce_interval = &(settings_find("hook_coalesce_interval")->value.i);
+    g_coalesced_hooks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify)coalesced_hook_free);
+    g_coalesced_pending = g_queue_new();
     g_event_window = XCreateSimpleWindow(g_display, g_root, 42, 42, 42, 42, 0, 0, 0);
     // set wm_class for window
     XClassHint *hint = XAllocClassHint();
@@ -37,6 +73,8 @@ void hook_init() {
 }
 
 void hook_destroy() {
+    g_hash_table_destroy(g_coalesced_hooks);
+    g_queue_free(g_coalesced_pending);
     // remove property from root window
     XDeleteProperty(g_display, g_root, ATOM(HERBST_HOOK_WIN_ID_ATOM));
     XDestroyWindow(g_display, g_event_window);
@@ -58,6 +96,112 @@ void hook_emit(int argc, const char** argv) {
     // set counter for next property
     last_property_number += 1;
     last_property_number %= HERBST_HOOK_PROPERTY_COUNT;
+    // and send it to the subscribers of the socket
+    g_hook_sequence++;
+    ipc_socket_emit_hook(g_hook_sequence, argc, argv);
+}
+
+void hook_emit_coalesced(const char* key, int argc, const char** argv) {
+    if (*g_hook_coalesce_interval <= 0) {
+        // the hook supersedes anything pending for this key
+        g_hash_table_remove(g_coalesced_hooks, key);
+        hook_emit(argc, argv);
+        return;
+    }
+    gint64 now = g_get_monotonic_time();
+    HSCoalescedHook* hook =
+        (HSCoalescedHook*)g_hash_table_lookup(g_coalesced_hooks, key);
+    if (!hook) {
+        // the first hook of an interval is emitted immediately
+        hook = g_new0(HSCoalescedHook, 1);
+        hook->interval_end = now + *g_hook_coalesce_interval * (gint64)1000;
+        g_hash_table_insert(g_coalesced_hooks, g_strdup(key), hook);
+        hook_emit(argc, argv);
+        return;
+    }
+    // remember only the latest hook, it is queued behind all other pending
+    // hooks
+    if (hook->pending) {
+        g_queue_remove(g_coalesced_pending, hook);
+    }
+    g_queue_push_tail(g_coalesced_pending, hook);
+    g_strfreev(hook->pending);
+    hook->pending = g_new(char*, argc + 1);
+    for (int i = 0; i < argc; i++) {
+        hook->pending[i] = g_strdup(argv[i]);
+    }
+    hook->pending[argc] = NULL;
+}
+
+void hook_flush_coalesced() {
+    if (g_hash_table_size(g_coalesced_hooks) == 0) {
+        return;
+    }
+    gint64 now = g_get_monotonic_time();
+    // drop the keys whose interval passed without further hooks
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, g_coalesced_hooks);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        HSCoalescedHook* hook = (HSCoalescedHook*)value;
+        if (hook->interval_end <= now && !hook->pending) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    // emit the latest hook of each passed interval, in the order they were
+    // queued
+    GList* link = g_coalesced_pending->head;
+    while (link) {
+        GList* next = link->next;
+        HSCoalescedHook* hook = (HSCoalescedHook*)link->data;
+        if (hook->interval_end <= now) {
+            coalesced_hook_emit_pending(hook, now);
+        }
+        link = next;
+    }
+}
+
+void hook_flush_coalesced_key(const char* key) {
+    HSCoalescedHook* hook =
+        (HSCoalescedHook*)g_hash_table_lookup(g_coalesced_hooks, key);
+    if (hook && hook->pending) {
+        coalesced_hook_emit_pending(hook, g_get_monotonic_time());
+    }
+}
+
+void hook_drop_coalesced(const char* key) {
+    g_hash_table_remove(g_coalesced_hooks, key);
+}
+
+void hook_drop_coalesced_prefix(const char* prefix, const char* keep) {
+    if (g_hash_table_size(g_coalesced_hooks) == 0) {
+        return;
+    }
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, g_coalesced_hooks);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        if (g_str_has_prefix((char*)key, prefix)
+            && !(keep && !strcmp((char*)key, keep))) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+}
+
+int hook_coalesce_timeout() {
+    if (g_hash_table_size(g_coalesced_hooks) == 0) {
+        return -1;
+    }
+    gint64 now = g_get_monotonic_time();
+    gint64 next = G_MAXINT64;
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, g_coalesced_hooks);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        next = MIN(next, ((HSCoalescedHook*)value)->interval_end);
+    }
+    // round up to whole milliseconds
+    return (int)MAX(0, (next - now + 999) / 1000);
 }
 
 void emit_tag_changed(HSTag* tag, int monitor) {
@@ -15,5 +15,22 @@ void hook_emit(int argc, const char** argv);
 void emit_tag_changed(HSTag* tag, int monitor);
 void hook_emit_list(const char* name, ...);
 
+// emits the hook at most once per hook_coalesce_interval for the given key.
+// Hooks emitted meanwhile are collapsed into the latest one, which is emitted
+// at the end of the interval by hook_flush_coalesced()
+void hook_emit_coalesced(const char* key, int argc, const char** argv);
+void hook_flush_coalesced();
+// emits the pending hook of the key now, e.g. before a hook that must not
+// overtake it
+void hook_flush_coalesced_key(const char* key);
+// forgets the pending hook and the interval of the key
+void hook_drop_coalesced(const char* key);
+// the same for all keys starting with prefix, except for the key keep (which
+// may be NULL)
+void hook_drop_coalesced_prefix(const char* prefix, const char* keep);
+// milliseconds until hook_flush_coalesced() has to be called, or -1 if there
+// is nothing to do
+int hook_coalesce_timeout();
+
 #endif
 
@@ -6,6 +6,8 @@
 #ifndef __HERBST_IPC_PROTOCOL_H_
 #define __HERBST_IPC_PROTOCOL_H_
 
+#include <stdint.h>
+
 #define HERBST_IPC_CLASS "HERBST_IPC_CLASS"
 //#define HERBST_IPC_READY "HERBST_IPC_READY"
 //#define HERBST_IPC_ATOM  "_HERBST_IPC"
@@ -18,6 +20,48 @@
 #define HERBST_HOOK_PROPERTY_FORMAT "__HERBST_HOOK_ARGUMENTS_%d"
 // maximum number of hooks to buffer
 #define HERBST_HOOK_PROPERTY_COUNT 10
+// maximum number of hooks to buffer for each hook subscriber of the socket
+#define HERBST_HOOK_QUEUE_LENGTH 1024
+
+// unix socket transport
+// if set, herbstclient uses this socket path instead of the default one
+#define HERBST_IPC_SOCKET_ENV "HERBSTLUFTWM_SOCKET"
+// default socket path: the directory ($XDG_RUNTIME_DIR or /tmp), the uid and
+// the display name without screen number and with slashes replaced by '_'
+#define HERBST_IPC_SOCKET_FORMAT "%s/herbstluftwm-%u-%s.sock"
+// messages bigger than this are rejected
+#define HERBST_IPC_MAX_MESSAGE_LENGTH (16 * 1024 * 1024)
+
+// every message on the socket consists of this header followed by 'length'
+// bytes of payload. All integers are in host byte order.
+typedef struct {
+    uint32_t    type;
+    uint32_t    length;
+} HerbstIpcHeader;
+
+// message types
+enum {
+    // payload: the arguments, each terminated by a null byte
+    HERBST_IPC_MSG_COMMAND = 1,
+    // payload: int32_t exit status followed by the output (not terminated)
+    HERBST_IPC_MSG_RESPONSE,
+    // payload: for each command a uint32_t length followed by that many
+    // bytes in the format of a HERBST_IPC_MSG_COMMAND payload
+    HERBST_IPC_MSG_BATCH,
+    // payload: for each command of the batch its int32_t exit status, the
+    // uint32_t length of its output and the output
+    HERBST_IPC_MSG_BATCH_RESPONSE,
+    // payload: filters in the format of a HERBST_IPC_MSG_COMMAND payload.
+    // Subscribes the connection to the hooks whose i'th argument matches the
+    // i'th filter (an extended regex). Answered by a HERBST_IPC_MSG_RESPONSE,
+    // which has a non-zero status and an error message if a filter is invalid
+    HERBST_IPC_MSG_SUBSCRIBE,
+    // payload: the uint64_t sequence number of the hook, the uint32_t number
+    // of hooks dropped for this subscriber since the previous
+    // HERBST_IPC_MSG_HOOK (because it did not read them fast enough), and
+    // the hook arguments, each terminated by a null byte
+    HERBST_IPC_MSG_HOOK,
+};
 
 // function exit codes
 enum {
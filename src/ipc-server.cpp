@@ -7,10 +7,19 @@
 #include "command.h"
 #include "utils.h"
 #include "ipc-protocol.h"
+#include "ipc-socket-path.h"
 #include "ipc-server.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include "glib-backports.h"
 
 #include <X11/Xlib.h>
@@ -18,12 +27,50 @@
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// a client connected via the unix socket
+typedef struct {
+    int         fd;
+    GString*    inbuf;  // received bytes that do not form a full message yet
+    GString*    outbuf; // bytes that could not be sent yet
+    bool        subscribed; // if it receives hooks
+    GQueue*     hooks;  // hook messages (GString*) not yet moved to outbuf
+    unsigned int hooks_dropped; // number of hooks dropped since the last one
+                                // that was queued
+    regex_t*    filters; // the i'th filter has to match the i'th argument
+    int         filter_count; // of a hook for it to be delivered
+} IpcSocketClient;
+
+static int      g_socket_fd = -1;
+static GString* g_socket_path = NULL;
+static GList*   g_socket_clients = NULL;
+
+static void ipc_socket_listen();
+static void ipc_socket_client_destroy(IpcSocketClient* client);
+static void ipc_socket_client_free_filters(IpcSocketClient* client);
+
 // public callable functions
 //
 void ipc_init() {
+    ipc_socket_listen();
 }
 
 void ipc_destroy() {
+    while (g_socket_clients) {
+        ipc_socket_client_destroy((IpcSocketClient*)g_socket_clients->data);
+    }
+    if (g_socket_fd >= 0) {
+        close(g_socket_fd);
+        unlink(g_socket_path->str);
+        g_socket_fd = -1;
+    }
+    if (g_socket_path) {
+        g_string_free(g_socket_path, true);
+        g_socket_path = NULL;
+    }
 }
 
 void ipc_add_connection(Window window) {
@@ -81,3 +128,413 @@ bool is_ipc_connectable(Window window) {
     return is_ipc;
 }
 
+
+// unix socket transport
+//
+static bool set_cloexec_nonblock(int fd) {
+    return fcntl(fd, F_SETFD, FD_CLOEXEC) != -1
+        && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != -1;
+}
+
+static void ipc_socket_listen() {
+    g_socket_path = g_string_new("");
+    ipc_socket_default_path(g_socket_path, DisplayString(g_display));
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (g_socket_path->len >= sizeof(addr.sun_path)) {
+        HSWarning("socket path \"%s\" is too long, "
+                  "disabling the socket transport\n", g_socket_path->str);
+        return;
+    }
+    strcpy(addr.sun_path, g_socket_path->str);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || !set_cloexec_nonblock(fd)) {
+        HSWarning("cannot create ipc socket: %s\n", strerror(errno));
+        if (fd >= 0) close(fd);
+        return;
+    }
+    // a stale socket can only be left by a crashed instance, because a
+    // running one would have been detected by checkotherwm()
+    unlink(addr.sun_path);
+    mode_t old_umask = umask(0077);
+    int status = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_umask);
+    if (status != 0 || listen(fd, SOMAXCONN) != 0) {
+        HSWarning("cannot listen on \"%s\": %s\n",
+                  addr.sun_path, strerror(errno));
+        close(fd);
+        return;
+    }
+    HSDebug("listening on socket %s\n", addr.sun_path);
+    g_socket_fd = fd;
+}
+
+static void ipc_socket_client_destroy(IpcSocketClient* client) {
+    g_socket_clients = g_list_remove(g_socket_clients, client);
+    close(client->fd);
+    g_string_free(client->inbuf, true);
+    g_string_free(client->outbuf, true);
+    while (!g_queue_is_empty(client->hooks)) {
+        g_string_free((GString*)g_queue_pop_head(client->hooks), true);
+    }
+    g_queue_free(client->hooks);
+    ipc_socket_client_free_filters(client);
+    g_free(client);
+}
+
+static void ipc_socket_accept() {
+    while (true) {
+        int fd = accept(g_socket_fd, NULL, NULL);
+        if (fd < 0) {
+            // EAGAIN: no more pending connections
+            return;
+        }
+        if (fd >= FD_SETSIZE || !set_cloexec_nonblock(fd)) {
+            HSWarning("dropping ipc connection on fd %d\n", fd);
+            close(fd);
+            continue;
+        }
+        IpcSocketClient* client = g_new0(IpcSocketClient, 1);
+        client->fd = fd;
+        client->inbuf = g_string_new("");
+        client->outbuf = g_string_new("");
+        client->hooks = g_queue_new();
+        g_socket_clients = g_list_append(g_socket_clients, client);
+    }
+}
+
+static bool ipc_socket_client_has_output(IpcSocketClient* client) {
+    return client->outbuf->len > 0 || !g_queue_is_empty(client->hooks);
+}
+
+// tries to send the pending output, returns false on a broken connection
+static bool ipc_socket_client_flush(IpcSocketClient* client) {
+    while (true) {
+        // refill the output buffer with queued hooks
+        while (client->outbuf->len < 4096 && !g_queue_is_empty(client->hooks)) {
+            GString* message = (GString*)g_queue_pop_head(client->hooks);
+            g_string_append_len(client->outbuf, message->str, message->len);
+            g_string_free(message, true);
+        }
+        if (client->outbuf->len == 0) {
+            break;
+        }
+        ssize_t n = send(client->fd, client->outbuf->str, client->outbuf->len,
+                         MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        g_string_erase(client->outbuf, 0, n);
+    }
+    return true;
+}
+
+static void ipc_socket_client_send(IpcSocketClient* client, uint32_t type,
+                                   const char* payload, size_t length) {
+    HerbstIpcHeader header;
+    header.type = type;
+    header.length = length;
+    g_string_append_len(client->outbuf, (const char*)&header, sizeof(header));
+    g_string_append_len(client->outbuf, payload, length);
+}
+
+// tells whether the payload consists of null terminated arguments
+static bool ipc_socket_arguments_valid(const char* payload, size_t length) {
+    return length == 0 || payload[length - 1] == '\0';
+}
+
+// splits a payload of null terminated arguments into a NULL terminated
+// argument vector pointing into the payload, which has to be freed with
+// g_free(). Returns NULL if the payload is malformed.
+static char** ipc_socket_split_arguments(char* payload, size_t length,
+                                         int* ret_argc) {
+    if (!ipc_socket_arguments_valid(payload, length)) {
+        return NULL;
+    }
+    // every argument is terminated by a null byte
+    int argc = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (payload[i] == '\0') argc++;
+    }
+    char** argv = g_new(char*, argc + 1);
+    char* arg = payload;
+    for (int i = 0; i < argc; i++) {
+        argv[i] = arg;
+        arg += strlen(arg) + 1;
+    }
+    argv[argc] = NULL;
+    *ret_argc = argc;
+    return argv;
+}
+
+// runs the command given by a HERBST_IPC_MSG_COMMAND payload, stores its exit
+// status in status and appends its output to output. Returns false if the
+// payload is malformed.
+static bool ipc_socket_run_command(char* payload, size_t length,
+                                   int32_t* status, GString* output) {
+    int argc;
+    char** argv = ipc_socket_split_arguments(payload, length, &argc);
+    if (!argv) {
+        return false;
+    }
+    *status = call_command(argc, argv, output);
+    g_free(argv);
+    return true;
+}
+
+static bool ipc_socket_handle_command(IpcSocketClient* client,
+                                      char* payload, size_t length) {
+    GString* output = g_string_new("");
+    int32_t status;
+    bool valid = ipc_socket_run_command(payload, length, &status, output);
+    if (valid) {
+        g_string_prepend_len(output, (const char*)&status, sizeof(status));
+        ipc_socket_client_send(client, HERBST_IPC_MSG_RESPONSE,
+                               output->str, output->len);
+    }
+    g_string_free(output, true);
+    return valid;
+}
+
+// tells whether the batch payload consists of length prefixed commands, each
+// of which is a valid list of arguments
+static bool ipc_socket_batch_valid(const char* payload, size_t length) {
+    size_t pos = 0;
+    while (pos < length) {
+        uint32_t cmd_length;
+        if (length - pos < sizeof(cmd_length)) {
+            return false;
+        }
+        memcpy(&cmd_length, payload + pos, sizeof(cmd_length));
+        pos += sizeof(cmd_length);
+        if (cmd_length > length - pos
+            || !ipc_socket_arguments_valid(payload + pos, cmd_length)) {
+            return false;
+        }
+        pos += cmd_length;
+    }
+    return true;
+}
+
+// runs all commands of the batch and sends one response containing the
+// output and exit status of each command. A malformed batch is rejected as
+// a whole before any of its commands is run.
+static bool ipc_socket_handle_batch(IpcSocketClient* client,
+                                    char* payload, size_t length) {
+    if (!ipc_socket_batch_valid(payload, length)) {
+        return false;
+    }
+    GString* response = g_string_new("");
+    GString* output = g_string_new("");
+    size_t pos = 0;
+    while (pos < length) {
+        uint32_t cmd_length;
+        memcpy(&cmd_length, payload + pos, sizeof(cmd_length));
+        pos += sizeof(cmd_length);
+        int32_t status;
+        g_string_truncate(output, 0);
+        ipc_socket_run_command(payload + pos, cmd_length, &status, output);
+        pos += cmd_length;
+        uint32_t output_length = output->len;
+        g_string_append_len(response, (const char*)&status, sizeof(status));
+        g_string_append_len(response, (const char*)&output_length,
+                            sizeof(output_length));
+        g_string_append_len(response, output->str, output->len);
+    }
+    ipc_socket_client_send(client, HERBST_IPC_MSG_BATCH_RESPONSE,
+                           response->str, response->len);
+    g_string_free(output, true);
+    g_string_free(response, true);
+    return true;
+}
+
+static void ipc_socket_client_free_filters(IpcSocketClient* client) {
+    for (int i = 0; i < client->filter_count; i++) {
+        regfree(client->filters + i);
+    }
+    g_free(client->filters);
+    client->filters = NULL;
+    client->filter_count = 0;
+}
+
+// (re)subscribes the client with the filters given in the payload. If a
+// filter is no valid regex, the subscription is left unchanged.
+static bool ipc_socket_handle_subscribe(IpcSocketClient* client,
+                                        char* payload, size_t length) {
+    int argc;
+    char** argv = ipc_socket_split_arguments(payload, length, &argc);
+    if (!argv) {
+        return false;
+    }
+    GString* output = g_string_new("");
+    int32_t status = HERBST_EXIT_SUCCESS;
+    regex_t* filters = g_new(regex_t, argc);
+    int i;
+    for (i = 0; i < argc; i++) {
+        int error = regcomp(filters + i, argv[i], REG_NOSUB|REG_EXTENDED);
+        if (error != 0) {
+            char buf[ERROR_STRING_BUF_SIZE];
+            regerror(error, filters + i, buf, ERROR_STRING_BUF_SIZE);
+            g_string_append_printf(output, "Cannot parse regex \"%s\": %s\n",
+                                   argv[i], buf);
+            status = HERBST_INVALID_ARGUMENT;
+            break;
+        }
+    }
+    if (status == HERBST_EXIT_SUCCESS) {
+        ipc_socket_client_free_filters(client);
+        client->filters = filters;
+        client->filter_count = argc;
+        client->subscribed = true;
+    } else {
+        // free the filters compiled so far
+        while (i-- > 0) {
+            regfree(filters + i);
+        }
+        g_free(filters);
+    }
+    g_free(argv);
+    g_string_prepend_len(output, (const char*)&status, sizeof(status));
+    ipc_socket_client_send(client, HERBST_IPC_MSG_RESPONSE,
+                           output->str, output->len);
+    g_string_free(output, true);
+    return true;
+}
+
+// returns whether the hook passes the filters of the subscriber. Like in
+// herbstclient, filters beyond the last argument are ignored.
+static bool ipc_socket_hook_matches(IpcSocketClient* client,
+                                    int argc, const char** argv) {
+    for (int i = 0; i < client->filter_count && i < argc; i++) {
+        if (0 != regexec(client->filters + i, argv[i], 0, NULL, 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ipc_socket_emit_hook(uint64_t sequence, int argc, const char** argv) {
+    for (GList* cur = g_socket_clients; cur; cur = cur->next) {
+        IpcSocketClient* client = (IpcSocketClient*)cur->data;
+        if (!client->subscribed || !ipc_socket_hook_matches(client, argc, argv)) {
+            continue;
+        }
+        if (g_queue_get_length(client->hooks) >= HERBST_HOOK_QUEUE_LENGTH) {
+            // the subscriber is too slow, it is told how many hooks it
+            // missed with the next hook it gets
+            client->hooks_dropped++;
+            continue;
+        }
+        GString* payload = g_string_new("");
+        uint32_t dropped = client->hooks_dropped;
+        g_string_append_len(payload, (const char*)&sequence, sizeof(sequence));
+        g_string_append_len(payload, (const char*)&dropped, sizeof(dropped));
+        for (int i = 0; i < argc; i++) {
+            g_string_append_len(payload, argv[i], strlen(argv[i]) + 1);
+        }
+        HerbstIpcHeader header;
+        header.type = HERBST_IPC_MSG_HOOK;
+        header.length = payload->len;
+        g_string_prepend_len(payload, (const char*)&header, sizeof(header));
+        g_queue_push_tail(client->hooks, payload);
+        client->hooks_dropped = 0;
+    }
+}
+
+// handles all complete messages in the input buffer, returns false if the
+// client sent garbage
+static bool ipc_socket_client_process(IpcSocketClient* client) {
+    HerbstIpcHeader header;
+    while (client->inbuf->len >= sizeof(header)) {
+        memcpy(&header, client->inbuf->str, sizeof(header));
+        if (header.length > HERBST_IPC_MAX_MESSAGE_LENGTH) {
+            return false;
+        }
+        size_t total = sizeof(header) + header.length;
+        if (client->inbuf->len < total) {
+            // wait for the rest of the message
+            break;
+        }
+        char* payload = client->inbuf->str + sizeof(header);
+        bool valid = false;
+        switch (header.type) {
+            case HERBST_IPC_MSG_COMMAND:
+                valid = ipc_socket_handle_command(client, payload,
+                                                  header.length);
+                break;
+            case HERBST_IPC_MSG_BATCH:
+                valid = ipc_socket_handle_batch(client, payload,
+                                                header.length);
+                break;
+            case HERBST_IPC_MSG_SUBSCRIBE:
+                valid = ipc_socket_handle_subscribe(client, payload,
+                                                    header.length);
+                break;
+        }
+        if (!valid) {
+            return false;
+        }
+        g_string_erase(client->inbuf, 0, total);
+    }
+    return true;
+}
+
+// returns false if the connection has been closed by the client
+static bool ipc_socket_client_read(IpcSocketClient* client) {
+    char buf[4096];
+    ssize_t n = recv(client->fd, buf, sizeof(buf), 0);
+    if (n == 0) {
+        return false;
+    }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    g_string_append_len(client->inbuf, buf, n);
+    return true;
+}
+
+int ipc_socket_fill_fds(fd_set* readfds, fd_set* writefds) {
+    if (g_socket_fd < 0) {
+        return -1;
+    }
+    int max_fd = g_socket_fd;
+    FD_SET(g_socket_fd, readfds);
+    for (GList* cur = g_socket_clients; cur; cur = cur->next) {
+        IpcSocketClient* client = (IpcSocketClient*)cur->data;
+        if (ipc_socket_client_has_output(client)) {
+            // do not read new commands before the client has received the
+            // output of the previous ones
+            FD_SET(client->fd, writefds);
+        } else {
+            FD_SET(client->fd, readfds);
+        }
+        max_fd = MAX(max_fd, client->fd);
+    }
+    return max_fd;
+}
+
+void ipc_socket_handle_fds(fd_set* readfds, fd_set* writefds) {
+    if (g_socket_fd < 0) {
+        return;
+    }
+    GList* next;
+    for (GList* cur = g_socket_clients; cur; cur = next) {
+        next = cur->next;
+        IpcSocketClient* client = (IpcSocketClient*)cur->data;
+        bool alive = true;
+        if (FD_ISSET(client->fd, readfds)) {
+            alive = ipc_socket_client_read(client)
+                    && ipc_socket_client_process(client);
+        }
+        if (alive && ipc_socket_client_has_output(client)) {
+            alive = ipc_socket_client_flush(client);
+        }
+        if (!alive) {
+            ipc_socket_client_destroy(client);
+        }
+    }
+    if (FD_ISSET(g_socket_fd, readfds)) {
+        ipc_socket_accept();
+    }
+}
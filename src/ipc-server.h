@@ -8,6 +8,8 @@
 
 #include <X11/Xlib.h>
 #include <stdbool.h>
+#include <sys/select.h>
+#include <stdint.h>
 
 void ipc_init();
 void ipc_destroy();
@@ -17,5 +19,13 @@ void ipc_add_connection(Window win);
 bool ipc_handle_connection(Window window);
 bool is_ipc_connectable(Window window);
 
+// unix socket transport: add the sockets to the fd sets for select() and
+// return the highest fd added (or -1)
+int ipc_socket_fill_fds(fd_set* readfds, fd_set* writefds);
+// handle the sockets that select() reported as ready
+void ipc_socket_handle_fds(fd_set* readfds, fd_set* writefds);
+// queue the hook for all subscribers of the socket
+void ipc_socket_emit_hook(uint64_t sequence, int argc, const char** argv);
+
 #endif
 
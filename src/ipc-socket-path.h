@@ -0,0 +1,51 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+#ifndef __HERBST_IPC_SOCKET_PATH_H_
+#define __HERBST_IPC_SOCKET_PATH_H_
+
+// the socket path rules, shared by herbstluftwm and herbstclient
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "ipc-protocol.h"
+
+// writes the path of the socket herbstluftwm listens on for the given
+// display (as in $DISPLAY, may be NULL) to path
+static inline void ipc_socket_default_path(GString* path, const char* display) {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    if (!dir || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+    char* name = g_strdup(display ? display : "");
+    // drop the screen number, because ":0" and ":0.0" are the same server
+    char* colon = strrchr(name, ':');
+    char* dot = colon ? strchr(colon, '.') : NULL;
+    if (dot) {
+        *dot = '\0';
+    }
+    g_strdelimit(name, "/", '_');
+    g_string_printf(path, HERBST_IPC_SOCKET_FORMAT,
+                    dir, (unsigned int)getuid(), name);
+    g_free(name);
+}
+
+// writes the path of the socket herbstclient connects to: the one from
+// HERBST_IPC_SOCKET_ENV if set, otherwise the default one. herbstluftwm does
+// not read the variable, such that an exported value cannot make a second
+// instance replace the socket of the first one.
+static inline void ipc_socket_client_path(GString* path, const char* display) {
+    const char* env = getenv(HERBST_IPC_SOCKET_ENV);
+    if (env && env[0] != '\0') {
+        g_string_assign(path, env);
+        return;
+    }
+    ipc_socket_default_path(path, display);
+}
+
+#endif
@@ -24,16 +24,65 @@ unsigned int* get_numlockmask_ptr() {
 }
 
 static GList* g_key_binds = NULL;
+// maps (keycode, cleaned modifiers) to the KeyBinding* triggered by it
+static GHashTable* g_key_table = NULL;
+// buffers for running the command of a key binding, reused for every press
+static GString* g_key_args_buf = NULL; // the arguments, each NUL-terminated
+static GArray*  g_key_args = NULL;     // char* pointing into g_key_args_buf
+static GString* g_key_output = NULL;
+
+// a compiled keymask of a client
+typedef struct {
+    char*       name;    // the keymask string, the key in g_key_masks
+    bool        valid;   // whether the regex could be compiled
+    regex_t     regex;
+    // memoizes the result for each KeyBinding*: 1 if it does not match, and 2
+    // if it matches the keymask
+    GHashTable* matches;
+} KeyMask;
+
+// how many keymasks are kept compiled, besides the current one
+#define KEYMASK_CACHE_SIZE 8
+
+// maps keymask strings to their KeyMask
+static GHashTable* g_key_masks = NULL;
+// the KeyMask* in g_key_masks, the most recently used first
+static GQueue* g_key_masks_lru = NULL;
+// the keymask the grabs are set up for, NULL if all key bindings are grabbed
+static KeyMask* g_key_mask = NULL;
+
+static void key_table_insert(KeyBinding* binding);
+static void key_table_remove(KeyBinding* binding);
+static void key_table_rebuild();
+static void keymask_free(KeyMask* mask);
+static void keymask_forget_binding(KeyBinding* binding);
+static void key_update_grab(KeyBinding* binding, void* data);
 
 void key_init() {
+    g_key_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_key_masks = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                        NULL, (GDestroyNotify)keymask_free);
+    g_key_masks_lru = g_queue_new();
+    g_key_args_buf = g_string_new("");
+    g_key_args = g_array_new(false, false, sizeof(char*));
+    g_key_output = g_string_new("");
     update_numlockmask();
 }
 
 void key_destroy() {
     key_remove_all_binds();
+    g_hash_table_destroy(g_key_table);
+    g_key_mask = NULL;
+    g_queue_free(g_key_masks_lru);
+    g_hash_table_destroy(g_key_masks);
+    g_string_free(g_key_args_buf, true);
+    g_array_free(g_key_args, true);
+    g_string_free(g_key_output, true);
 }
 
 void key_remove_all_binds() {
+    g_hash_table_remove_all(g_key_table);
+    g_list_foreach(g_key_binds, (GFunc)keymask_forget_binding, NULL);
     g_list_free_full(g_key_binds, (GDestroyNotify)keybinding_free);
     g_key_binds = NULL;
     regrab_keys();
@@ -106,12 +155,16 @@ int keybind(int argc, char** argv, GString* output) {
     // create a copy of the command to execute on this key
     new_bind.cmd_argc = argc - 2;
     new_bind.cmd_argv = argv_duplicate(new_bind.cmd_argc, argv+2);
+    new_bind.command = find_command(new_bind.cmd_argv[0]);
+    new_bind.keycode = 0;
+    new_bind.enabled = false;
     // add keybinding
     KeyBinding* data = g_new(KeyBinding, 1);
     *data = new_bind;
     g_key_binds = g_list_append(g_key_binds, data);
-    // grab for events on this keycode
-    grab_keybind(data, NULL);
+    key_table_insert(data);
+    // grab for events on this keycode, unless the keymask disables it
+    key_update_grab(data, NULL);
     return 0;
 }
 
@@ -163,20 +216,67 @@ static gint keysym_equals(const KeyBinding* a, const KeyBinding* b) {
     return equal ? 0 : -1;
 }
 
+static gpointer key_table_key(unsigned int keycode, unsigned int modifiers) {
+    return GUINT_TO_POINTER((keycode << 16) | (CLEANMASK(modifiers) & 0xffff));
+}
+
+static void key_table_insert(KeyBinding* binding) {
+    binding->keycode = 0;
+    KeyCode keycode = XKeysymToKeycode(g_display, binding->keysym);
+    // a key press only triggers a binding for the keysym without modifiers
+    if (!keycode
+        || XkbKeycodeToKeysym(g_display, keycode, 0, 0) != binding->keysym) {
+        return;
+    }
+    gpointer key = key_table_key(keycode, binding->modifiers);
+    if (g_hash_table_lookup(g_key_table, key)) {
+        // the first binding in the list wins
+        return;
+    }
+    binding->keycode = keycode;
+    g_hash_table_insert(g_key_table, key, binding);
+}
+
+static void key_table_remove(KeyBinding* binding) {
+    if (!binding->keycode) {
+        return;
+    }
+    gpointer key = key_table_key(binding->keycode, binding->modifiers);
+    if (g_hash_table_lookup(g_key_table, key) == binding) {
+        g_hash_table_remove(g_key_table, key);
+    }
+    binding->keycode = 0;
+}
+
+static void key_table_rebuild() {
+    g_hash_table_remove_all(g_key_table);
+    g_list_foreach(g_key_binds, (GFunc)key_table_insert, NULL);
+}
+
 void handle_key_press(XEvent* ev) {
-    KeyBinding pressed;
-    pressed.keysym = XkbKeycodeToKeysym(g_display, ev->xkey.keycode, 0, 0);
-    pressed.modifiers = ev->xkey.state;
-    GList* element = g_list_find_custom(g_key_binds, &pressed, (GCompareFunc)keysym_equals);
-    if (element && element->data) {
-        KeyBinding* found = (KeyBinding*)element->data;
-        // duplicate the args in the case this keybinding removes itself
-        char** argv =  argv_duplicate(found->cmd_argc, found->cmd_argv);
-        int argc = found->cmd_argc;
-        // call the command
-        call_command_no_output(argc, argv);
-        argv_free(argc, argv);
+    KeyBinding* found = (KeyBinding*)g_hash_table_lookup(g_key_table,
+        key_table_key(ev->xkey.keycode, ev->xkey.state));
+    if (!found) {
+        return;
     }
+    // copy the args, because the command may modify them or remove this
+    // keybinding. The copy lives in buffers reused for every key press.
+    int argc = found->cmd_argc;
+    g_string_truncate(g_key_args_buf, 0);
+    for (int i = 0; i < argc; i++) {
+        g_string_append_len(g_key_args_buf, found->cmd_argv[i],
+                            strlen(found->cmd_argv[i]) + 1);
+    }
+    g_array_set_size(g_key_args, argc);
+    char* arg = g_key_args_buf->str;
+    for (int i = 0; i < argc; i++) {
+        g_array_index(g_key_args, char*, i) = arg;
+        arg += strlen(arg) + 1;
+    }
+    // call the command
+    g_string_truncate(g_key_output, 0);
+    call_command_binding(found->command, argc, (char**)g_key_args->data,
+                         g_key_output);
 }
 
 int keyunbind(int argc, char** argv, GString* output) {
@@ -214,6 +314,12 @@ bool key_remove_bind_with_keysym(unsigned int modifiers, KeySym keysym){
         return false;
     }
     KeyBinding* data = (KeyBinding*)element->data;
+    if (data->enabled) {
+        // the grab would otherwise outlive the binding
+        ungrab_keybind(data, NULL);
+    }
+    key_table_remove(data);
+    keymask_forget_binding(data);
     keybinding_free(data);
     g_key_binds = g_list_remove_link(g_key_binds, element);
     g_list_free_1(element);
@@ -224,7 +330,13 @@ void regrab_keys() {
     update_numlockmask();
     // init modifiers after updating numlockmask
     XUngrabKey(g_display, AnyKey, AnyModifier, g_root); // remove all current grabs
-    g_list_foreach(g_key_binds, (GFunc)grab_keybind, NULL);
+    for (GList* cur = g_key_binds; cur; cur = cur->next) {
+        ((KeyBinding*)cur->data)->enabled = false;
+    }
+    // grab all keys the keymask does not disable
+    g_list_foreach(g_key_binds, (GFunc)key_update_grab, NULL);
+    // the keycodes or the numlock mask may have changed
+    key_table_rebuild();
 }
 
 void grab_keybind(KeyBinding* binding, void* useless_pointer) {
@@ -379,25 +491,93 @@ void complete_against_modifiers(const char* needle, char seperator,
     g_string_free(buf, true);
 }
 
-static void key_set_keymask_helper(KeyBinding* b, regex_t *keymask_regex) {
-    // add keybinding
-    bool enabled = true;
-    if (keymask_regex != NULL) {
-        GString* name = keybinding_to_g_string(b);
-        regmatch_t match;
-        int status = regexec(keymask_regex, name->str, 1, &match, 0);
-        // only accept it, if it matches the entire string
-        if (status == 0
-            && match.rm_so == 0
-            && match.rm_eo == strlen(name->str)) {
-            enabled = true;
-        } else {
-            // Keybinding did not match, therefore we disable it
-            enabled = false;
+static void keymask_free(KeyMask* mask) {
+    if (mask->valid) {
+        regfree(&mask->regex);
+    }
+    g_hash_table_destroy(mask->matches);
+    g_free(mask->name);
+    g_free(mask);
+}
+
+static void keymask_forget_binding_helper(void* key, KeyMask* mask,
+                                          KeyBinding* binding) {
+    (void) key;
+    g_hash_table_remove(mask->matches, binding);
+}
+
+// removes the memoized results for a binding that is freed
+static void keymask_forget_binding(KeyBinding* binding) {
+    g_hash_table_foreach(g_key_masks, (GHFunc)keymask_forget_binding_helper,
+                         binding);
+}
+
+// drops the least recently used keymasks until at most KEYMASK_CACHE_SIZE
+// are left besides the current one
+static void keymask_evict() {
+    GList* link = g_key_masks_lru->tail;
+    while (link && g_queue_get_length(g_key_masks_lru) > KEYMASK_CACHE_SIZE) {
+        GList* prev = link->prev;
+        KeyMask* mask = (KeyMask*)link->data;
+        if (mask != g_key_mask) {
+            g_queue_delete_link(g_key_masks_lru, link);
+            g_hash_table_remove(g_key_masks, mask->name);
+        }
+        link = prev;
+    }
+}
+
+// returns the compiled keymask for the given string, or NULL if it is
+// not a valid regex
+static KeyMask* keymask_get(const char* str) {
+    KeyMask* mask = (KeyMask*)g_hash_table_lookup(g_key_masks, str);
+    if (mask) {
+        g_queue_remove(g_key_masks_lru, mask);
+        g_queue_push_head(g_key_masks_lru, mask);
+    } else {
+        mask = g_new0(KeyMask, 1);
+        mask->name = g_strdup(str);
+        mask->matches = g_hash_table_new(g_direct_hash, g_direct_equal);
+        int status = regcomp(&mask->regex, str, REG_EXTENDED);
+        mask->valid = (status == 0);
+        if (!mask->valid) {
+            char buf[ERROR_STRING_BUF_SIZE];
+            regerror(status, &mask->regex, buf, ERROR_STRING_BUF_SIZE);
+            HSDebug("keymask: Can not parse regex \"%s\" from keymask: %s",
+                    str, buf);
         }
-        g_string_free(name, true);
+        g_hash_table_insert(g_key_masks, mask->name, mask);
+        g_queue_push_head(g_key_masks_lru, mask);
+        keymask_evict();
     }
+    return mask->valid ? mask : NULL;
+}
+
+// tells whether the keymask keeps the binding enabled
+static bool keymask_allows(KeyMask* mask, KeyBinding* b) {
+    if (!mask) {
+        return true;
+    }
+    int memo = GPOINTER_TO_INT(g_hash_table_lookup(mask->matches, b));
+    if (memo) {
+        return memo == 2;
+    }
+    GString* name = keybinding_to_g_string(b);
+    regmatch_t match;
+    int status = regexec(&mask->regex, name->str, 1, &match, 0);
+    // only accept it, if it matches the entire string
+    bool enabled = status == 0
+                   && match.rm_so == 0
+                   && match.rm_eo == name->len;
+    g_string_free(name, true);
+    g_hash_table_insert(mask->matches, b, GINT_TO_POINTER(enabled ? 2 : 1));
+    return enabled;
+}
 
+// grabs or ungrabs the binding according to the current keymask
+static void key_update_grab(KeyBinding* b, void* data) {
+    (void) data;
+    bool enabled = keymask_allows(g_key_mask, b);
     if (enabled && !b->enabled) {
         grab_keybind(b, NULL);
     } else if(!enabled && b->enabled) {
@@ -406,20 +586,16 @@ static void key_set_keymask_helper(KeyBinding* b, regex_t *keymask_regex) {
 }
 
 void key_set_keymask(HSTag *tag, HSClient *client) {
-    regex_t     keymask_regex;
-    if (client && strlen(client->keymask->str) > 0) {
-        int status = regcomp(&keymask_regex, client->keymask->str, REG_EXTENDED);
-        if (status == 0) {
-            g_list_foreach(g_key_binds, (GFunc)key_set_keymask_helper,
-                           &keymask_regex);
-            return;
-        } else {
-            char buf[ERROR_STRING_BUF_SIZE];
-            regerror(status, &keymask_regex, buf, ERROR_STRING_BUF_SIZE);
-            HSDebug("keymask: Can not parse regex \"%s\" from keymask: %s",
-                    client->keymask->str, buf);
-        }
+    KeyMask* mask = NULL;
+    if (client && client->keymask->len > 0) {
+        mask = keymask_get(client->keymask->str);
+    }
+    if (mask == g_key_mask) {
+        // the grabs are already set up for this keymask
+        return;
     }
-    // Enable all keys again
-    g_list_foreach(g_key_binds, (GFunc)key_set_keymask_helper, 0);
+    g_key_mask = mask;
+    // only the bindings whose state changed are (un)grabbed. The requests are
+    // buffered by Xlib and sent together
+    g_list_foreach(g_key_binds, (GFunc)key_update_grab, NULL);
 }
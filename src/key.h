@@ -18,7 +18,9 @@ typedef struct KeyBinding {
     unsigned int modifiers;
     int     cmd_argc; // number of arguments for command
     char**  cmd_argv; // arguments for command to call
+    struct CommandBinding* command; // the resolved cmd_argv[0] or NULL
     bool    enabled;  // Is the keybinding already grabbed
+    KeyCode keycode;  // the keycode it is indexed by or 0
 } KeyBinding;
 
 unsigned int modifiername2mask(const char* name);
@@ -41,6 +43,7 @@ void complete_against_modifiers(const char* needle, char seperator,
 void complete_against_keysyms(const char* needle, char* prefix, GString* output);
 void regrab_keys();
 void grab_keybind(KeyBinding* binding, void* useless_pointer);
+void ungrab_keybind(KeyBinding* binding, void* useless_pointer);
 void update_numlockmask();
 unsigned int* get_numlockmask_ptr();
 void key_set_keymask(HSTag * tag, HSClient *client);
@@ -170,6 +170,7 @@ void frame_insert_client(HSFrame* frame, struct HSClient* client) {
         // write results back
         frame->content.clients.count = count;
         frame->content.clients.buf = buf;
+        client->frame = frame;
         // check for focus
         if (g_cur_frame == frame
             && frame->content.clients.selection >= (count-1)) {
@@ -208,63 +209,80 @@ HSFrame* lookup_frame(HSFrame* root, const char *index) {
     return lookup_frame(new_root, new_index);
 }
 
-HSFrame* find_frame_with_client(HSFrame* frame, struct HSClient* client) {
-    if (frame->type == TYPE_CLIENTS) {
-        HSClient** buf = frame->content.clients.buf;
-        size_t count = frame->content.clients.count;
-        for (int i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                return frame;
-            }
+// tells whether frame is root or one of its subframes
+static bool frame_is_below(HSFrame* frame, HSFrame* root) {
+    for (; frame; frame = frame->parent) {
+        if (frame == root) {
+            return true;
         }
-        return NULL;
-    } else { /* frame->type == TYPE_FRAMES */
-        HSFrame* found = find_frame_with_client(frame->content.layout.a, client);
-        if (!found) {
-            found = find_frame_with_client(frame->content.layout.b, client);
+    }
+    return false;
+}
+
+// returns the index of the client in the client frame or -1
+static int frame_client_index(HSFrame* frame, HSClient* client) {
+    HSClient** buf = frame->content.clients.buf;
+    size_t count = frame->content.clients.count;
+    for (int i = 0; i < count; i++) {
+        if (buf[i] == client) {
+            return i;
         }
+    }
+    return -1;
+}
+
+// updates the frame pointer of the clients after they were moved to frame
+static void frame_adopt_clients(HSFrame* frame) {
+    if (frame->type != TYPE_CLIENTS) {
+        return;
+    }
+    for (size_t i = 0; i < frame->content.clients.count; i++) {
+        frame->content.clients.buf[i]->frame = frame;
+    }
+}
+
+HSFrame* find_frame_with_client(HSFrame* frame, struct HSClient* client) {
+    HSFrame* found = client->frame;
+    if (found && frame_is_below(found, frame)) {
         return found;
     }
+    return NULL;
 }
 
 bool frame_remove_client(HSFrame* frame, HSClient* client) {
-    if (frame->type == TYPE_CLIENTS) {
-        HSClient** buf = frame->content.clients.buf;
-        size_t count = frame->content.clients.count;
-        int i;
-        for (i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                // if window was found
-                // them remove it
-                memmove(buf+i, buf+i+1, sizeof(buf[0])*(count - i - 1));
-                count--;
-                buf = g_renew(HSClient*, buf, count);
-                frame->content.clients.buf = buf;
-                frame->content.clients.count = count;
-                // find out new selection
-                int selection = frame->content.clients.selection;
-                // if selection was before removed window
-                // then do nothing
-                // else shift it by 1
-                selection -= (selection < i) ? 0 : 1;
-                // ensure, that it's a valid index
-                selection = count ? CLAMP(selection, 0, count-1) : 0;
-                frame->content.clients.selection = selection;
-                return true;
-            }
-        }
+    frame = find_frame_with_client(frame, client);
+    if (!frame) {
         return false;
-    } else { /* frame->type == TYPE_FRAMES */
-        bool found = frame_remove_client(frame->content.layout.a, client);
-        found = found || frame_remove_client(frame->content.layout.b, client);
-        return found;
     }
+    HSClient** buf = frame->content.clients.buf;
+    size_t count = frame->content.clients.count;
+    int i = frame_client_index(frame, client);
+    assert(i >= 0);
+    memmove(buf+i, buf+i+1, sizeof(buf[0])*(count - i - 1));
+    count--;
+    buf = g_renew(HSClient*, buf, count);
+    frame->content.clients.buf = buf;
+    frame->content.clients.count = count;
+    // find out new selection
+    int selection = frame->content.clients.selection;
+    // if selection was before removed window
+    // then do nothing
+    // else shift it by 1
+    selection -= (selection < i) ? 0 : 1;
+    // ensure, that it's a valid index
+    selection = count ? CLAMP(selection, 0, count-1) : 0;
+    frame->content.clients.selection = selection;
+    client->frame = NULL;
+    return true;
 }
 
 void frame_destroy(HSFrame* frame, HSClient*** buf, size_t* count) {
     if (frame->type == TYPE_CLIENTS) {
         *buf = frame->content.clients.buf;
         *count = frame->content.clients.count;
+        for (size_t i = 0; i < *count; i++) {
+            (*buf)[i]->frame = NULL;
+        }
     } else { /* frame->type == TYPE_FRAMES */
         size_t c1, c2;
         HSClient **buf1, **buf2;
@@ -447,6 +465,7 @@ char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg) {
             frame->content.clients.count = count;
             frame->content.clients.selection = 0; // only some sane defaults
             frame->content.clients.layout = 0; // only some sane defaults
+            frame_adopt_clients(frame);
         }
 
         // bring child wins
@@ -482,6 +501,8 @@ char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg) {
                 monitor_apply_layout(clientmonitor);
             }
             stack_remove_slice(client->tag->stack, client->slice);
+            rectindex_remove(client->tag->rects, client);
+            tag_flags_remove_client(client->tag, client);
 
             // insert it to buf
             HSClient** buf = frame->content.clients.buf;
@@ -494,9 +515,12 @@ char* load_frame_tree(HSFrame* frame, char* description, GString* errormsg) {
             buf[index] = client;
             frame->content.clients.buf = buf;
             frame->content.clients.count = count;
+            client->frame = frame;
 
             client->tag = tag;
             stack_insert_slice(client->tag->stack, client->slice);
+            rectindex_insert(client->tag->rects, client);
+            tag_flags_add_client(client->tag, client);
             ewmh_window_update_tag(client->window, client->tag);
 
             index++;
@@ -1203,6 +1227,7 @@ bool frame_split(HSFrame* frame, int align, int fraction) {
     HSFrame* second = frame_create_empty(frame, NULL);
     first->content = frame->content;
     first->type = frame->type;
+    frame_adopt_clients(first);
     second->type = TYPE_CLIENTS;
     frame->type = TYPE_FRAMES;
     frame->content.layout.align = align;
@@ -1231,6 +1256,7 @@ int frame_split_command(int argc, char** argv, GString* output) {
                                         0.0 + FRAME_MIN_FRACTION,
                                         1.0 - FRAME_MIN_FRACTION);
     int selection = 0;
+    monitors_apply_dirty_layouts(); // ensure last_rect is up to date
     int lh = g_cur_frame->last_rect.height;
     int lw = g_cur_frame->last_rect.width;
     int align_auto = (lw > lh) ? ALIGN_HORIZONTAL : ALIGN_VERTICAL;
@@ -1306,6 +1332,7 @@ int frame_split_command(int argc, char** argv, GString* output) {
         *buf1 = g_renew(HSClient*, *buf1, nc1);
         child1->content.clients.count = nc1;
         child2->content.clients.count = nc2;
+        frame_adopt_clients(child2);
         child2->content.clients.layout = child1->content.clients.layout;
         if (child1->content.clients.selection >= nc1 && nc1 > 0) {
             child2->content.clients.selection =
@@ -1604,15 +1631,10 @@ int frame_move_window_command(int argc, char** argv, GString* output) {
             // focus right window in frame
             HSFrame* frame = g_cur_frame;
             assert(frame);
-            int i;
-            HSClient** buf = frame->content.clients.buf;
-            size_t count = frame->content.clients.count;
-            for (i = 0; i < count; i++) {
-                if (buf[i] == client) {
-                    frame->content.clients.selection = i;
-                    client_window_focus(buf[i]);
-                    break;
-                }
+            if (client->frame == frame) {
+                frame->content.clients.selection =
+                    frame_client_index(frame, client);
+                client_window_focus(client);
             }
 
             // layout was changed, so update it
@@ -1655,36 +1677,17 @@ bool frame_focus_client(HSFrame* frame, HSClient* client) {
     if (!frame) {
         return false;
     }
-    if (frame->type == TYPE_CLIENTS) {
-        int i;
-        size_t count = frame->content.clients.count;
-        HSClient** buf = frame->content.clients.buf;
-        // search for win in buf
-        for (i = 0; i < count; i++) {
-            if (buf[i] == client) {
-                // if found, set focus to it
-                frame->content.clients.selection = i;
-                return true;
-            }
-        }
-        return false;
-    } else {
-        // type == TYPE_FRAMES
-        // search in subframes
-        bool found = frame_focus_client(frame->content.layout.a, client);
-        if (found) {
-            // set selection to first frame
-            frame->content.layout.selection = 0;
-            return true;
-        }
-        found = frame_focus_client(frame->content.layout.b, client);
-        if (found) {
-            // set selection to second frame
-            frame->content.layout.selection = 1;
-            return true;
-        }
+    HSFrame* leaf = find_frame_with_client(frame, client);
+    if (!leaf) {
         return false;
     }
+    leaf->content.clients.selection = frame_client_index(leaf, client);
+    // select the path from frame down to the leaf
+    for (HSFrame* cur = leaf; cur != frame; cur = cur->parent) {
+        HSLayout* layout = &cur->parent->content.layout;
+        layout->selection = (layout->a == cur) ? 0 : 1;
+    }
+    return true;
 }
 
 // focus a window
@@ -1890,6 +1893,7 @@ int frame_remove_command(int argc, char** argv) {
         parent->content.layout.a->parent = parent;
         parent->content.layout.b->parent = parent;
     }
+    frame_adopt_clients(parent);
     g_free(second);
     // re-layout
     frame_focus_recursive(parent);
@@ -20,9 +20,6 @@
 #define LAYOUT_DUMP_SEPARATOR_STR ":" /* must be a string with one char */
 #define LAYOUT_DUMP_SEPARATOR LAYOUT_DUMP_SEPARATOR_STR[0]
 
-#define TAG_SET_FLAG(tag, flag) \
-    ((tag)->flags |= (flag))
-
 enum {
     TAG_FLAG_URGENT = 0x01, // is there a urgent window?
     TAG_FLAG_USED   = 0x02, // the opposite of empty
@@ -21,6 +21,7 @@
 #include "object.h"
 #include "decoration.h"
 #include "desktopwindow.h"
+#include "profile.h"
 // standard
 #include <string.h>
 #include <stdio.h>
@@ -199,6 +200,7 @@ CommandBinding g_commands[] = {
     CMD_BIND(             "getenv",         getenv_command),
     CMD_BIND(             "setenv",         setenv_command),
     CMD_BIND(             "unsetenv",       unsetenv_command),
+    CMD_BIND(             "profile",        profile_command),
     { CommandBindingCB() }
 };
 
@@ -310,7 +312,6 @@ int load_command(int argc, char** argv, GString* output) {
     if (output->len > 0) {
         g_string_prepend(output, "load: ");
     }
-    tag_set_flags_dirty(); // we probably changed some window positions
     // arrange monitor
     HSMonitor* m = find_monitor_with_tag(tag);
     if (m) {
@@ -349,7 +350,6 @@ int print_tag_status_command(int argc, char** argv, GString* output) {
             "%s: Monitor \"%s\" not found!\n", argv[0], argv[1]);
         return HERBST_INVALID_ARGUMENT;
     }
-    tag_update_flags();
     g_string_append_c(output, '\t');
     for (int i = 0; i < tag_get_count(); i++) {
         HSTag* tag = get_tag_by_index(i);
@@ -541,6 +541,11 @@ void event_on_configure(XEvent event) {
             if (width_requested) newRect.width = cre->width;
             if (height_requested) newRect.height = cre->height;
         }
+        if (changes) {
+            // the request must be answered by a configure notify even if it
+            // results in the current geometry, so don't let it be elided
+            client->dec.last_geometry_applied = false;
+        }
         if (changes && is_client_floated(client)) {
             client->float_size = newRect;
             client_resize_floating(client, find_monitor_with_tag(client->tag));
@@ -629,6 +634,13 @@ void scan(void) {
     XWindowAttributes wa;
 
     ewmh_get_original_client_list(&cl, &cl_count);
+    // the set of windows managed by the previous window manager
+    GHashTable* original_clients = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (int i = 0; i < cl_count; i++) {
+        g_hash_table_insert(original_clients, GSIZE_TO_POINTER(cl[i]), cl + i);
+    }
+    // the attributes are fetched once per window and then passed on to
+    // manage_client(), so it does not need to fetch the geometry again
     if (XQueryTree(g_display, g_root, &d1, &d2, &wins, &num)) {
         for (int i = 0; i < num; i++) {
             if(!XGetWindowAttributes(g_display, wins[i], &wa)
@@ -639,15 +651,17 @@ void scan(void) {
             // but manage it if it was in the ewmh property _NET_CLIENT_LIST by
             // the previous window manager
             // TODO: what would dwm do?
-            if (is_window_mapped(g_display, wins[i])
-                || 0 <= array_find(cl, cl_count, sizeof(Window), wins+i)) {
-                manage_client(wins[i]);
+            if (wa.map_state == IsViewable
+                || g_hash_table_lookup(original_clients,
+                                       GSIZE_TO_POINTER(wins[i]))) {
+                manage_client(wins[i], false, &wa);
                 XMapWindow(g_display, wins[i]);
             }
         }
         if(wins)
             XFree(wins);
     }
+    g_hash_table_destroy(original_clients);
     // ensure every original client is managed again
     for (int i = 0; i < cl_count; i++) {
         if (get_client_from_window(cl[i])) continue;
@@ -658,10 +672,20 @@ void scan(void) {
             continue;
         }
         XReparentWindow(g_display, cl[i], g_root, 0,0);
-        manage_client(cl[i]);
+        // the attributes were fetched relative to the old parent
+        wa.x = 0;
+        wa.y = 0;
+        manage_client(cl[i], false, &wa);
     }
 }
 
+// logs how long a phase of the startup took and starts the next one
+static void startup_phase_done(const char* phase, gint64* phase_start) {
+    gint64 now = g_get_monotonic_time();
+    HSDebug("startup: %s took %.1f ms\n", phase, (now - *phase_start) / 1000.0);
+    *phase_start = now;
+}
+
 void execute_autostart_file() {
     GString* path = NULL;
     if (g_autostart_path) {
@@ -789,8 +813,11 @@ static struct {
     void (*init)();
     void (*destroy)();
 } g_modules[] = {
+    { atoms_init,       atoms_destroy       },
+    { command_init,     command_destroy     },
     { ipc_init,         ipc_destroy         },
     { object_tree_init, object_tree_destroy },
+    { profile_init,     profile_destroy     },
     { key_init,         key_destroy         },
     { settings_init,    settings_destroy    },
     { reload_tree_style,NULL                },
@@ -830,7 +857,7 @@ void buttonpress(XEvent* event) {
 
 void buttonrelease(XEvent* event) {
     HSDebug("name is: ButtonRelease\n");
-    mouse_stop_drag();
+    mouse_finish_drag();
 }
 
 void createnotify(XEvent* event) {
@@ -968,6 +995,12 @@ void propertynotify(XEvent* event) {
             } else if (ev->atom == XA_WM_NAME ||
                        ev->atom == g_netatom[NetWmName]) {
                 client_update_title(client);
+            } else if (ev->atom == XA_WM_CLASS) {
+                client_update_class(client);
+            } else if (ev->atom == g_netatom[NetWmWindowType]) {
+                client_update_window_type(client);
+            } else if (ev->atom == ATOM("WM_WINDOW_ROLE")) {
+                client_update_window_role(client);
             }
         }
     }
@@ -1004,42 +1037,85 @@ int main(int argc, char* argv[]) {
     XSelectInput(g_display, g_root, ROOT_EVENT_MASK);
 
     // initialize subsystems
+    gint64 startup_begin = g_get_monotonic_time();
+    gint64 phase_start = startup_begin;
     for (int i = 0; i < LENGTH(g_modules); i++) {
         if (g_modules[i].init) {
             g_modules[i].init();
         }
     }
     fetch_settings();
+    ensure_monitors_are_available();
+    startup_phase_done("initialization", &phase_start);
 
     // setup
-    ensure_monitors_are_available();
     scan();
-    tag_force_update_flags();
+    startup_phase_done("scanning the windows", &phase_start);
     all_monitors_apply_layout();
     ewmh_update_all();
     execute_autostart_file();
     clientlist_end_startup();
+    startup_phase_done("autostart", &phase_start);
+    // the windows found by scan() are laid out only once, here
+    monitors_apply_dirty_layouts();
+    ewmh_flush_client_lists();
+    tag_flush_flags();
+    startup_phase_done("layouting", &phase_start);
+    startup_phase_done("startup", &startup_begin);
 
     // main loop
     XEvent event;
     int x11_fd;
     fd_set in_fds;
+    fd_set out_fds;
     x11_fd = ConnectionNumber(g_display);
     while (!g_aboutToQuit) {
         FD_ZERO(&in_fds);
+        FD_ZERO(&out_fds);
         FD_SET(x11_fd, &in_fds);
-        // wait for an event or a signal
-        select(x11_fd + 1, &in_fds, 0, 0, NULL);
+        int max_fd = MAX(x11_fd, ipc_socket_fill_fds(&in_fds, &out_fds));
+        // wait for an event or a signal, or until coalesced hooks or the
+        // next drag update are due
+        int timeout_ms = hook_coalesce_timeout();
+        int drag_timeout_ms = mouse_drag_timeout();
+        if (drag_timeout_ms >= 0
+            && (timeout_ms < 0 || drag_timeout_ms < timeout_ms)) {
+            timeout_ms = drag_timeout_ms;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        if (select(max_fd + 1, &in_fds, &out_fds, 0,
+                   timeout_ms >= 0 ? &timeout : NULL) < 0) {
+            FD_ZERO(&in_fds);
+            FD_ZERO(&out_fds);
+        }
         if (g_aboutToQuit) {
             break;
         }
-        while (XPending(g_display)) {
-            XNextEvent(g_display, &event);
-            void (*handler) (XEvent*) = g_default_handler[event.type];
-            if (handler != NULL) {
-                handler(&event);
+        // handle socket commands first, XPending() then flushes their requests
+        // and the hooks
+        ipc_socket_handle_fds(&in_fds, &out_fds);
+        hook_flush_coalesced();
+        mouse_drag_flush();
+        do {
+            while (XPending(g_display)) {
+                XNextEvent(g_display, &event);
+                void (*handler) (XEvent*) = g_default_handler[event.type];
+                if (handler != NULL) {
+                    HSProfileStart start = profile_begin();
+                    handler(&event);
+                    profile_end_event(event.type, start);
+                }
             }
-        }
+            // layout each monitor changed by this batch of events only once,
+            // and update the client lists afterwards. This syncs with the
+            // server, so events may have been queued meanwhile which select()
+            // would not report anymore
+            monitors_apply_dirty_layouts();
+            ewmh_flush_client_lists();
+            tag_flush_flags();
+        } while (XPending(g_display));
     }
 
     // destroy all subsystems
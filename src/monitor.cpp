@@ -25,6 +25,7 @@
 #include "stack.h"
 #include "clientlist.h"
 #include "desktopwindow.h"
+#include "profile.h"
 
 // module internals:
 static int g_cur_monitor;
@@ -36,6 +37,7 @@ static HSStack* g_monitor_stack;
 static GArray*     g_monitors; // Array of HSMonitor*
 static HSObject*   g_monitor_object;
 static HSObject*   g_monitor_by_name_object;
+static GArray*     g_restack_buf; // scratch buffer of monitor_restack()
 
 typedef struct RectList {
     Rectangle rect;
@@ -53,6 +55,7 @@ void monitor_init() {
     g_smart_frame_surroundings = &(settings_find("smart_frame_surroundings")->value.i);
     g_mouse_recenter_gap       = &(settings_find("mouse_recenter_gap")->value.i);
     g_monitor_stack = stack_create();
+    g_restack_buf = g_array_new(false, false, sizeof(Window));
     g_monitor_object = hsobject_create_and_link(hsobject_root(), "monitors");
     HSAttribute attributes[] = {
         ATTRIBUTE("count", g_monitors->len, ATTR_READ_ONLY),
@@ -72,20 +75,27 @@ void monitor_destroy() {
             g_string_free(m->name, true);
         }
         g_string_free(m->display_name, true);
+        g_array_free(m->restacked.windows, true);
         g_free(m);
     }
     hsobject_unlink_and_destroy(g_monitor_object, g_monitor_by_name_object);
     hsobject_unlink_and_destroy(hsobject_root(), g_monitor_object);
     stack_destroy(g_monitor_stack);
+    g_array_free(g_restack_buf, true);
     g_array_free(g_monitors, true);
 }
 
 void monitor_apply_layout(HSMonitor* monitor) {
+    // only mark it dirty, the main loop applies the layout of all dirty
+    // monitors once after all pending events have been handled
     if (monitor) {
-        if (*g_monitors_locked) {
-            monitor->dirty = true;
-            return;
-        }
+        monitor->dirty = true;
+    }
+}
+
+static void monitor_apply_layout_now(HSMonitor* monitor) {
+    if (monitor) {
+        HSProfileStart start = profile_begin();
         monitor->dirty = false;
         Rectangle rect = monitor->rect;
         // apply pad
@@ -115,6 +125,16 @@ void monitor_apply_layout(HSMonitor* monitor) {
         // remove all enternotify-events from the event queue that were
         // generated while arranging the clients on this monitor
         drop_enternotify_events();
+        profile_end(g_profile_layout, start);
+    }
+}
+
+// applies the layout right away, unless the monitors are locked. Then it is
+// only marked dirty and applied by monitors_unlock()
+static void monitor_apply_layout_unless_locked(HSMonitor* monitor) {
+    monitor_apply_layout(monitor);
+    if (!*g_monitors_locked) {
+        monitor_apply_layout_now(monitor);
     }
 }
 
@@ -339,7 +359,9 @@ int set_monitor_rects(Rectangle* templates, size_t count) {
         if (!tag) {
             return HERBST_TAG_IN_USE;
         }
-        add_monitor(templates[i], tag, NULL);
+        HSMonitor* monitor = add_monitor(templates[i], tag, NULL);
+        // layout the windows before showing them
+        monitor_apply_layout_unless_locked(monitor);
         frame_show_recursive(tag->frame);
     }
     // remove monitors if there are too much
@@ -469,6 +491,7 @@ HSMonitor* add_monitor(Rectangle rect, HSTag* tag, char* name) {
     m->slice = slice_create_monitor(m);
     m->stacking_window = XCreateSimpleWindow(g_display, g_root,
                                              42, 42, 42, 42, 1, 0, 0);
+    m->restacked.windows = g_array_new(false, false, sizeof(Window));
 
     m->object.data = m;
     HSAttribute attributes[] = {
@@ -535,7 +558,8 @@ int add_monitor_command(int argc, char** argv, GString* output) {
         }
     }
     HSMonitor* monitor = add_monitor(rect, tag, name);
-    monitor_apply_layout(monitor);
+    // layout the windows before showing them
+    monitor_apply_layout_unless_locked(monitor);
     frame_show_recursive(tag->frame);
     emit_tag_changed(tag, g_monitors->len - 1);
     drop_enternotify_events();
@@ -593,6 +617,7 @@ int remove_monitor(int index) {
         g_string_free(monitor->name, true);
     }
     g_string_free(monitor->display_name, true);
+    g_array_free(monitor->restacked.windows, true);
     monitor_foreach(monitor_unlink_id_object);
     g_array_remove_index(g_monitors, index);
     g_free(monitor);
@@ -848,8 +873,10 @@ int monitor_set_tag(HSMonitor* monitor, HSTag* tag) {
     // first reset focus and arrange windows
     frame_focus_recursive(tag->frame);
     monitor_restack(monitor);
+    // the windows have to be at their place before they are shown, so
+    // do not wait for the deferred layout
     monitor->lock_frames = true;
-    monitor_apply_layout(monitor);
+    monitor_apply_layout_unless_locked(monitor);
     monitor->lock_frames = false;
     // then show them (should reduce flicker)
     frame_show_recursive(tag->frame);
@@ -989,9 +1016,10 @@ void monitor_focus_by_index(int new_selection) {
     assert(monitor->tag->frame);
     g_cur_monitor = new_selection;
     frame_focus_recursive(monitor->tag->frame);
-    // repaint monitors
+    // repaint monitors, the new one right away because of the pointer
+    // warp below
     monitor_apply_layout(old);
-    monitor_apply_layout(monitor);
+    monitor_apply_layout_unless_locked(monitor);
     int rx, ry;
     {
         // save old mouse position
@@ -1107,13 +1135,18 @@ void monitors_lock_changed() {
         *g_monitors_locked = 0;
         HSDebug("fixing invalid monitors_locked value to 0\n");
     }
-    if (!*g_monitors_locked) {
-        // if not locked anymore, then repaint all the dirty monitors
-        for (int i = 0; i < g_monitors->len; i++) {
-            HSMonitor* m = monitor_with_index(i);
-            if (m->dirty) {
-                monitor_apply_layout(m);
-            }
+    // if not locked anymore, then repaint all the dirty monitors
+    monitors_apply_dirty_layouts();
+}
+
+void monitors_apply_dirty_layouts() {
+    if (*g_monitors_locked) {
+        return;
+    }
+    for (int i = 0; i < g_monitors->len; i++) {
+        HSMonitor* m = monitor_with_index(i);
+        if (m->dirty) {
+            monitor_apply_layout_now(m);
         }
     }
 }
@@ -1299,19 +1332,19 @@ int detect_monitors_command(int argc, const char **argv, GString* output) {
     return ret;
 }
 
-int monitor_stack_window_count(bool real_clients) {
-    return stack_window_count(g_monitor_stack, real_clients);
-}
-
-void monitor_stack_to_window_buf(Window* buf, int len, bool real_clients,
-                                 int* remain_len) {
-    stack_to_window_buf(g_monitor_stack, buf, len, real_clients, remain_len);
+void monitor_stack_append_windows(GArray* windows, bool real_clients) {
+    stack_append_windows(g_monitor_stack, windows, real_clients);
 }
 
 HSStack* get_monitor_stack() {
     return g_monitor_stack;
 }
 
+static void monitor_invalidate_restack(HSMonitor* monitor) {
+    g_array_set_size(monitor->restacked.windows, 0);
+    monitor->restacked.tag = NULL;
+}
+
 int monitor_raise_command(int argc, char** argv, GString* output) {
     char* cmd_name = argv[0];
     (void)SHIFT(argc, argv);
@@ -1327,26 +1360,44 @@ int monitor_raise_command(int argc, char** argv, GString* output) {
         monitor = get_current_monitor();
     }
     stack_raise_slide(g_monitor_stack, monitor->slice);
+    stack_restack(g_monitor_stack);
+    // the windows of all monitors were restacked
+    for (int i = 0; i < g_monitors->len; i++) {
+        monitor_invalidate_restack(monitor_with_index(i));
+    }
     return 0;
 }
 
 void monitor_restack(HSMonitor* monitor) {
-    int count = 1 + stack_window_count(monitor->tag->stack, false);
-    Window* buf = g_new(Window, count);
-    buf[0] = monitor->stacking_window;
-    stack_to_window_buf(monitor->tag->stack, buf + 1, count - 1, false, NULL);
-    /* remove a focused fullscreen client */
-    HSClient* client = frame_focused_client(monitor->tag->frame);
-    if (client && client->fullscreen) {
-        XRaiseWindow(g_display, client->dec.decwin);
-        int idx = array_find(buf, count, sizeof(*buf), &client->dec.decwin);
-        assert(idx >= 0);
-        count--;
-        memmove(buf + idx, buf + idx + 1, sizeof(*buf) * (count - idx));
+    HSTag* tag = monitor->tag;
+    HSClient* client = frame_focused_client(tag->frame);
+    Window fullscreen = (client && client->fullscreen) ? client->dec.decwin : 0;
+    if (!tag->stack->dirty && monitor->restacked.tag == tag
+        && monitor->restacked.fullscreen == fullscreen) {
+        // nothing changed since the last restack
+        return;
+    }
+    GArray* windows = stack_windows(tag->stack);
+    g_array_set_size(g_restack_buf, 0);
+    g_array_append_val(g_restack_buf, monitor->stacking_window);
+    for (int i = 0; i < windows->len; i++) {
+        Window win = g_array_index(windows, Window, i);
+        /* remove a focused fullscreen client */
+        if (win != fullscreen) {
+            g_array_append_val(g_restack_buf, win);
+        }
+    }
+    if (fullscreen) {
+        XRaiseWindow(g_display, fullscreen);
     }
     DesktopWindow::lowerDesktopWindows();
-    XRestackWindows(g_display, buf, count);
-    g_free(buf);
+    stack_restack_windows(monitor->restacked.windows,
+                          &g_array_index(g_restack_buf, Window, 0),
+                          g_restack_buf->len);
+    tag->stack->dirty = false;
+    monitor->restacked.tag = tag;
+    monitor->restacked.fullscreen = fullscreen;
+    ewmh_update_client_list_stacking();
 }
 
 int shift_to_monitor(int argc, char** argv, GString* output) {
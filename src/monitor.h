@@ -43,6 +43,12 @@ typedef struct HSMonitor {
     } mouse;
     Rectangle   rect;   // area for this monitor
     Window      stacking_window;   // window used for making stacking easy
+    struct {
+        // state of the last monitor_restack()
+        GArray*         windows;    // windows from top to bottom
+        struct HSTag*   tag;
+        Window          fullscreen; // raised fullscreen client or 0
+    } restacked;
 } HSMonitor;
 
 void monitor_init();
@@ -93,6 +99,10 @@ void monitors_lock_changed();
 int monitor_lock_tag_command(int argc, char** argv, GString* output);
 int monitor_unlock_tag_command(int argc, char** argv, GString* output);
 void monitor_apply_layout(HSMonitor* monitor);
+// applies the layout of all monitors marked dirty by monitor_apply_layout(),
+// unless the monitors are locked. Call this before reading frame or client
+// geometry that may be outdated.
+void monitors_apply_dirty_layouts();
 void all_monitors_apply_layout();
 void ensure_monitors_are_available();
 void all_monitors_replace_previous_tag(struct HSTag* old, struct HSTag* newmon);
@@ -100,9 +110,7 @@ void all_monitors_replace_previous_tag(struct HSTag* old, struct HSTag* newmon);
 void drop_enternotify_events();
 
 void monitor_restack(HSMonitor* monitor);
-int monitor_stack_window_count(bool real_clients);
-void monitor_stack_to_window_buf(Window* buf, int len, bool real_clients,
-                                 int* remain_len);
+void monitor_stack_append_windows(GArray* windows, bool real_clients);
 struct HSStack* get_monitor_stack();
 
 void monitor_update_focus_objects();
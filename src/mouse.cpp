@@ -12,6 +12,7 @@
 #include "utils.h"
 #include "settings.h"
 #include "command.h"
+#include "monitor.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -38,6 +39,10 @@ static GList* g_mouse_binds = NULL;
 static unsigned int* g_numlockmask_ptr;
 static int* g_snap_distance;
 static int* g_snap_gap;
+static int* g_drag_update_rate;
+static bool             g_drag_motion_pending; // g_drag_motion not applied yet
+static XMotionEvent     g_drag_motion; // the latest motion of the drag
+static gint64           g_drag_last_update; // monotonic time in microseconds
 
 #define CLEANMASK(mask)         ((mask) & ~(*g_numlockmask_ptr|LockMask))
 #define REMOVEBUTTONMASK(mask) ((mask) & \
@@ -51,6 +56,7 @@ void mouse_init() {
     g_numlockmask_ptr = get_numlockmask_ptr();
     g_snap_distance = &(settings_find("snap_distance")->value.i);
     g_snap_gap = &(settings_find("snap_gap")->value.i);
+    g_drag_update_rate = &(settings_find("drag_update_rate")->value.i);
     /* set cursor theme */
     g_cursor = XCreateFontCursor(g_display, XC_left_ptr);
     XDefineCursor(g_display, g_root, g_cursor);
@@ -70,23 +76,23 @@ void mouse_handle_event(XEvent* ev) {
         // there is no valid bind for this type of mouse event
         return;
     }
-    b->action(client, b->argc, b->argv);
+    b->action(client, b);
 }
 
-void mouse_initiate_move(HSClient* client, int argc, char** argv) {
-    (void) argc; (void) argv;
+void mouse_initiate_move(HSClient* client, MouseBinding* bind) {
+    (void) bind;
     mouse_initiate_drag(client, mouse_function_move);
 }
 
-void mouse_initiate_zoom(HSClient* client, int argc, char** argv) {
-    (void) argc; (void) argv;
+void mouse_initiate_zoom(HSClient* client, MouseBinding* bind) {
+    (void) bind;
     if (is_client_floated(client))
 	mouse_initiate_drag(client, mouse_function_zoom);
     else return;
 }
 
-void mouse_initiate_resize(HSClient* client, int argc, char** argv) {
-    (void) argc; (void) argv;
+void mouse_initiate_resize(HSClient* client, MouseBinding* bind) {
+    (void) bind;
     if (is_client_floated(client)) {
         mouse_initiate_drag(client, mouse_function_resize_floated);
     } else {
@@ -94,11 +100,20 @@ void mouse_initiate_resize(HSClient* client, int argc, char** argv) {
     }
 }
 
-void mouse_call_command(struct HSClient* client, int argc, char** argv) {
+void mouse_call_command(struct HSClient* client, MouseBinding* bind) {
     // TODO: add completion
+    if (!bind) {
+        return;
+    }
+    // duplicate the args in the case this mousebinding removes itself
+    int argc = bind->argc;
+    char** argv = argv_duplicate(argc, bind->argv);
+    GString* output = g_string_new("");
     client_set_dragged(client, true);
-    call_command_no_output(argc, argv);
+    call_command_binding(bind->command, argc, argv, output);
     client_set_dragged(client, false);
+    g_string_free(output, true);
+    argv_free(argc, argv);
 }
 
 
@@ -112,22 +127,37 @@ void mouse_initiate_drag(HSClient* client, MouseDragFunction function) {
         return;
     }
     client_set_dragged(g_win_drag_client, true);
+    // the drag functions rely on the current geometry of frames and clients
+    monitors_apply_dirty_layouts();
     g_win_drag_start = g_win_drag_client->float_size;
     g_button_drag_start = get_cursor_position();
     g_drag_init_done = false;
+    g_drag_motion_pending = false;
+    g_drag_last_update = 0;
     XGrabPointer(g_display, client->window, True,
         PointerMotionMask|ButtonReleaseMask, GrabModeAsync,
             GrabModeAsync, None, None, CurrentTime);
 }
 
+void mouse_finish_drag() {
+    if (g_drag_motion_pending && g_drag_function) {
+        // the client ends up at the last pointer position
+        g_drag_motion_pending = false;
+        g_drag_function(&g_drag_motion);
+    }
+    mouse_stop_drag();
+}
+
 void mouse_stop_drag() {
+    // a pending motion is discarded, e.g. if the drag was canceled
+    g_drag_motion_pending = false;
+    g_drag_function = NULL;
     if (g_win_drag_client) {
         client_set_dragged(g_win_drag_client, false);
         // resend last size
         monitor_apply_layout(g_drag_monitor);
     }
     g_win_drag_client = NULL;
-    g_drag_function = NULL;
     XUngrabPointer(g_display, CurrentTime);
     // remove all enternotify-events from the event queue that were
     // generated by the XUngrabPointer
@@ -143,14 +173,43 @@ void handle_motion_event(XEvent* ev) {
     if (ev->type != MotionNotify) return;
     // get newest motion notification
     while (XCheckMaskEvent(g_display, ButtonMotionMask, ev));
-    // call function that handles it
-    g_drag_function(&(ev->xmotion));
+    // remember it and apply it now or when drag_update_rate allows it
+    g_drag_motion = ev->xmotion;
+    g_drag_motion_pending = true;
+    mouse_drag_flush();
+}
+
+int mouse_drag_timeout() {
+    if (!g_drag_motion_pending || !g_drag_function) {
+        return -1;
+    }
+    if (*g_drag_update_rate <= 0) {
+        return 0;
+    }
+    gint64 next = g_drag_last_update + 1000000 / *g_drag_update_rate;
+    gint64 now = g_get_monotonic_time();
+    // round up to whole milliseconds
+    return (int)MAX(0, (next - now + 999) / 1000);
+}
+
+void mouse_drag_flush() {
+    if (mouse_drag_timeout() != 0) {
+        return;
+    }
+    g_drag_motion_pending = false;
+    g_drag_last_update = g_get_monotonic_time();
+    g_drag_function(&g_drag_motion);
 }
 
 bool mouse_is_dragging() {
     return g_drag_function != NULL;
 }
 
+bool mouse_drag_affects(HSClient* client) {
+    return g_drag_function && g_drag_monitor
+        && g_drag_monitor->tag == client->tag;
+}
+
 static void mouse_binding_free(void* voidmb) {
     MouseBinding* mb = (MouseBinding*)voidmb;
     if (!mb) return;
@@ -210,7 +269,8 @@ int mouse_bind_command(int argc, char** argv, GString* output) {
     mb->modifiers = modifiers;
     mb->action = function;
     mb->argc = argc - 3;
-    mb->argv = argv_duplicate(argc - 3, argv + 3);;
+    mb->argv = argv_duplicate(argc - 3, argv + 3);
+    mb->command = (mb->argc > 0) ? find_command(mb->argv[0]) : NULL;
     g_mouse_binds = g_list_prepend(g_mouse_binds, mb);
     HSClient* client = get_current_client();
     if (client) {
@@ -635,8 +695,27 @@ void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
         snap_1d(d.rect.y + d.rect.height, m->rect.y + m->rect.height - m->pad_down - *g_snap_gap, &d.dy);
     }
 
-    // snap to other clients
-    frame_foreach_client(tag->frame, (ClientAction)client_snap_helper, &d);
+    // snap to other clients, i.e. only to those with an edge in snap distance
+    struct {
+        enum SnapFlags  flag;
+        enum HSRectEdge edge;   // the edge of the other clients
+        int             pos;    // the position where this edge snaps exactly
+    } edges[] = {
+        { SNAP_EDGE_RIGHT,  RECT_EDGE_LEFT,   d.rect.x + d.rect.width + *g_snap_gap },
+        { SNAP_EDGE_LEFT,   RECT_EDGE_RIGHT,  d.rect.x - *g_snap_gap },
+        { SNAP_EDGE_TOP,    RECT_EDGE_BOTTOM, d.rect.y - *g_snap_gap },
+        { SNAP_EDGE_BOTTOM, RECT_EDGE_TOP,    d.rect.y + d.rect.height + *g_snap_gap },
+    };
+    FOR (i,0,LENGTH(edges)) {
+        if (!(flags & edges[i].flag)) {
+            continue;
+        }
+        d.flags = edges[i].flag;
+        rectindex_foreach_in_range(tag->rects, edges[i].edge,
+                                   edges[i].pos - distance,
+                                   edges[i].pos + distance,
+                                   (ClientAction)client_snap_helper, &d);
+    }
 
     // write back results
     if (abs(d.dx) < abs(distance)) {
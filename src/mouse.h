@@ -30,8 +30,12 @@ void mouse_init();
 void mouse_destroy();
 
 
+struct MouseBinding;
+struct CommandBinding;
+
 typedef void (*MouseDragFunction)(XMotionEvent*);
-typedef void (*MouseFunction)(struct HSClient* client, int argc, char** argv);
+// bind is NULL if the function is not triggered by a mouse binding
+typedef void (*MouseFunction)(struct HSClient* client, struct MouseBinding* bind);
 
 typedef struct MouseBinding {
     unsigned int modifiers;
@@ -39,6 +43,7 @@ typedef struct MouseBinding {
     MouseFunction action;
     int     argc; // additional arguments
     char**  argv;
+    struct CommandBinding* command; // the resolved argv[0] or NULL
 } MouseBinding;
 
 int mouse_binding_equals(MouseBinding* a, MouseBinding* b);
@@ -54,9 +59,19 @@ void grab_client_buttons(struct HSClient* client, bool focused);
 
 void mouse_handle_event(XEvent* ev);
 void mouse_initiate_drag(struct HSClient* client, MouseDragFunction function);
+// applies the pending pointer motion and stops the drag
+void mouse_finish_drag();
+// stops the drag, without applying the pending pointer motion
 void mouse_stop_drag();
 bool mouse_is_dragging();
+// tells whether a drag is in progress on the tag of the client
+bool mouse_drag_affects(struct HSClient* client);
 void handle_motion_event(XEvent* ev);
+// returns the milliseconds until the next drag update is due, or -1 if no
+// update is pending
+int mouse_drag_timeout();
+// applies the latest pointer motion to the drag if it is due
+void mouse_drag_flush();
 
 // get the vector to snap a client to it's neighbour
 void client_snap_vector(struct HSClient* client, struct HSMonitor* monitor,
@@ -67,10 +82,10 @@ bool is_point_between(int point, int left, int right);
 // tells if the intervals [a_left, a_right) [b_left, b_right) intersect
 bool intervals_intersect(int a_left, int a_right, int b_left, int b_right);
 
-void mouse_initiate_move(struct HSClient* client, int argc, char** argv);
-void mouse_initiate_zoom(struct HSClient* client, int argc, char** argv);
-void mouse_initiate_resize(struct HSClient* client, int argc, char** argv);
-void mouse_call_command(struct HSClient* client, int argc, char** argv);
+void mouse_initiate_move(struct HSClient* client, MouseBinding* bind);
+void mouse_initiate_zoom(struct HSClient* client, MouseBinding* bind);
+void mouse_initiate_resize(struct HSClient* client, MouseBinding* bind);
+void mouse_call_command(struct HSClient* client, MouseBinding* bind);
 /* some mouse drag functions */
 void mouse_function_move(XMotionEvent* me);
 void mouse_function_resize_floated(XMotionEvent* me);
@@ -0,0 +1,259 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+#include "profile.h"
+#include "globals.h"
+#include "utils.h"
+#include "object.h"
+#include "ipc-protocol.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <X11/Xlib.h>
+
+struct HSProfileCounter {
+    HSObject*       parent;
+    HSObject*       object;
+    GString*        path;       // path relative to the profile object
+    unsigned int    count;
+    unsigned long long total_us;
+    unsigned int    max_us;
+    unsigned long long requests; // X requests issued while measuring
+    unsigned int    buckets[PROFILE_BUCKET_COUNT];
+};
+
+bool g_profile_enabled = false;
+HSProfileCounter* g_profile_layout;
+HSProfileCounter* g_profile_rules;
+HSProfileCounter* g_profile_resize_outline;
+
+static HSObject*    g_profile_object;
+static HSObject*    g_profile_commands_object;
+static HSObject*    g_profile_events_object;
+static GHashTable*  g_profile_commands; // maps command names to counters
+static HSProfileCounter* g_profile_events[LASTEvent];
+static GList*       g_profile_counters; // all counters in creation order
+static unsigned long g_profile_request_base; // serial of the last reset
+
+static const char* g_event_names[] = {
+    NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+    "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+    "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+    "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+    "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+    "ConfigureRequest", "GravityNotify", "ResizeRequest",
+    "CirculateNotify", "CirculateRequest", "PropertyNotify",
+    "SelectionClear", "SelectionRequest", "SelectionNotify",
+    "ColormapNotify", "ClientMessage", "MappingNotify", "GenericEvent",
+};
+
+static void profile_counter_total_us(void* data, GString* output) {
+    HSProfileCounter* counter = (HSProfileCounter*)data;
+    g_string_append_printf(output, "%llu", counter->total_us);
+}
+
+static void profile_counter_requests(void* data, GString* output) {
+    HSProfileCounter* counter = (HSProfileCounter*)data;
+    g_string_append_printf(output, "%llu", counter->requests);
+}
+
+static void profile_total_requests(void* data, GString* output) {
+    (void)data;
+    g_string_append_printf(output, "%lu",
+                           NextRequest(g_display) - g_profile_request_base);
+}
+
+// returns an upper bound for the given percentile of the durations, which is
+// exact up to a factor of two
+static unsigned int profile_counter_percentile(HSProfileCounter* counter,
+                                               unsigned int percent) {
+    if (counter->count == 0) {
+        return 0;
+    }
+    unsigned long long needed =
+        ((unsigned long long)counter->count * percent + 99) / 100;
+    unsigned long long seen = 0;
+    for (int i = 0; i < PROFILE_BUCKET_COUNT; i++) {
+        seen += counter->buckets[i];
+        if (seen >= needed) {
+            unsigned long long bound = (2ull << i) - 1;
+            return MIN(bound, counter->max_us);
+        }
+    }
+    return counter->max_us;
+}
+
+static int profile_counter_p50(void* data) {
+    return profile_counter_percentile((HSProfileCounter*)data, 50);
+}
+
+static int profile_counter_p99(void* data) {
+    return profile_counter_percentile((HSProfileCounter*)data, 99);
+}
+
+static HSProfileCounter* profile_counter_create(HSObject* parent,
+                                                const char* parent_path,
+                                                const char* name) {
+    HSProfileCounter* counter = g_new0(HSProfileCounter, 1);
+    counter->path = g_string_new(parent_path);
+    if (counter->path->len > 0) {
+        g_string_append_c(counter->path, OBJECT_PATH_SEPARATOR);
+    }
+    g_string_append(counter->path, name);
+    counter->parent = parent;
+    counter->object = hsobject_create_and_link(parent, name);
+    counter->object->data = counter;
+    HSAttribute attributes[] = {
+        ATTRIBUTE_UINT(     "count",    counter->count,     ATTR_READ_ONLY),
+        ATTRIBUTE_CUSTOM(   "total_us", profile_counter_total_us, ATTR_READ_ONLY),
+        ATTRIBUTE_UINT(     "max_us",   counter->max_us,    ATTR_READ_ONLY),
+        ATTRIBUTE_CUSTOM_INT("p50_us",  profile_counter_p50, ATTR_READ_ONLY),
+        ATTRIBUTE_CUSTOM_INT("p99_us",  profile_counter_p99, ATTR_READ_ONLY),
+        ATTRIBUTE_CUSTOM(   "x_requests", profile_counter_requests, ATTR_READ_ONLY),
+        ATTRIBUTE_LAST,
+    };
+    hsobject_set_attributes(counter->object, attributes);
+    g_profile_counters = g_list_append(g_profile_counters, counter);
+    return counter;
+}
+
+static void profile_counter_reset(HSProfileCounter* counter) {
+    counter->count = 0;
+    counter->total_us = 0;
+    counter->max_us = 0;
+    counter->requests = 0;
+    memset(counter->buckets, 0, sizeof(counter->buckets));
+}
+
+void profile_init() {
+    g_profile_object = hsobject_create_and_link(hsobject_root(), "profile");
+    HSAttribute attributes[] = {
+        ATTRIBUTE_BOOL(     "enabled",    g_profile_enabled,  ATTR_ACCEPT_ALL),
+        ATTRIBUTE_CUSTOM(   "x_requests", profile_total_requests, ATTR_READ_ONLY),
+        ATTRIBUTE_LAST,
+    };
+    hsobject_set_attributes(g_profile_object, attributes);
+    g_profile_request_base = NextRequest(g_display);
+    g_profile_commands_object =
+        hsobject_create_and_link(g_profile_object, "commands");
+    g_profile_events_object =
+        hsobject_create_and_link(g_profile_object, "events");
+    g_profile_commands = g_hash_table_new(g_str_hash, g_str_equal);
+    g_profile_layout =
+        profile_counter_create(g_profile_object, "", "layout");
+    g_profile_rules =
+        profile_counter_create(g_profile_object, "", "rules");
+    g_profile_resize_outline =
+        profile_counter_create(g_profile_object, "", "resize_outline");
+}
+
+void profile_destroy() {
+    for (GList* cur = g_profile_counters; cur; cur = cur->next) {
+        HSProfileCounter* counter = (HSProfileCounter*)cur->data;
+        hsobject_unlink_and_destroy(counter->parent, counter->object);
+        g_string_free(counter->path, true);
+        g_free(counter);
+    }
+    g_list_free(g_profile_counters);
+    g_profile_counters = NULL;
+    g_hash_table_destroy(g_profile_commands);
+    memset(g_profile_events, 0, sizeof(g_profile_events));
+    hsobject_unlink_and_destroy(g_profile_object, g_profile_commands_object);
+    hsobject_unlink_and_destroy(g_profile_object, g_profile_events_object);
+    hsobject_unlink_and_destroy(hsobject_root(), g_profile_object);
+}
+
+HSProfileStart profile_begin() {
+    HSProfileStart start;
+    if (g_profile_enabled) {
+        start.time = g_get_monotonic_time();
+        start.request = NextRequest(g_display);
+    } else {
+        start.time = 0;
+        start.request = 0;
+    }
+    return start;
+}
+
+void profile_end(HSProfileCounter* counter, HSProfileStart start) {
+    if (start.time == 0) {
+        // profiling was disabled when the measurement began
+        return;
+    }
+    gint64 duration = MAX(0, g_get_monotonic_time() - start.time);
+    int bucket = 0;
+    while (bucket < PROFILE_BUCKET_COUNT - 1 && (2ll << bucket) - 1 <= duration) {
+        bucket++;
+    }
+    counter->count++;
+    counter->total_us += duration;
+    counter->max_us = MAX(counter->max_us, (unsigned int)MIN(duration, G_MAXUINT));
+    counter->requests += NextRequest(g_display) - start.request;
+    counter->buckets[bucket]++;
+}
+
+void profile_end_command(const char* name, HSProfileStart start) {
+    if (start.time == 0) {
+        return;
+    }
+    HSProfileCounter* counter =
+        (HSProfileCounter*)g_hash_table_lookup(g_profile_commands, name);
+    if (!counter) {
+        counter = profile_counter_create(g_profile_commands_object,
+                                         "commands", name);
+        // the key is owned by the counter
+        const char* key = counter->path->str + strlen("commands.");
+        g_hash_table_insert(g_profile_commands, (gpointer)key, counter);
+    }
+    profile_end(counter, start);
+}
+
+void profile_end_event(int type, HSProfileStart start) {
+    if (start.time == 0 || type < 0 || type >= LASTEvent) {
+        return;
+    }
+    if (!g_profile_events[type]) {
+        char name[STRING_BUF_SIZE];
+        if (type < LENGTH(g_event_names) && g_event_names[type]) {
+            g_strlcpy(name, g_event_names[type], STRING_BUF_SIZE);
+        } else {
+            snprintf(name, STRING_BUF_SIZE, "%d", type);
+        }
+        g_profile_events[type] =
+            profile_counter_create(g_profile_events_object, "events", name);
+    }
+    profile_end(g_profile_events[type], start);
+}
+
+int profile_command(int argc, char** argv, GString* output) {
+    if (argc < 2) {
+        return HERBST_NEED_MORE_ARGS;
+    }
+    if (!strcmp(argv[1], "reset")) {
+        g_profile_request_base = NextRequest(g_display);
+        for (GList* cur = g_profile_counters; cur; cur = cur->next) {
+            profile_counter_reset((HSProfileCounter*)cur->data);
+        }
+    } else if (!strcmp(argv[1], "dump")) {
+        g_string_append(output,
+            "name\tcount\ttotal_us\tp50_us\tp99_us\tmax_us\tx_requests\n");
+        for (GList* cur = g_profile_counters; cur; cur = cur->next) {
+            HSProfileCounter* counter = (HSProfileCounter*)cur->data;
+            if (counter->count == 0) {
+                continue;
+            }
+            g_string_append_printf(output, "%s\t%u\t%llu\t%u\t%u\t%u\t%llu\n",
+                counter->path->str, counter->count, counter->total_us,
+                profile_counter_percentile(counter, 50),
+                profile_counter_percentile(counter, 99),
+                counter->max_us, counter->requests);
+        }
+    } else {
+        g_string_append_printf(output,
+            "%s: Unknown argument \"%s\"\n", argv[0], argv[1]);
+        return HERBST_INVALID_ARGUMENT;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/** Copyright 2011-2013 Thorsten Wißmann. All rights reserved.
+ *
+ * This software is licensed under the "Simplified BSD License".
+ * See LICENSE for details */
+
+#ifndef __HERBST_PROFILE_H_
+#define __HERBST_PROFILE_H_
+
+#include <stdbool.h>
+#include "glib-backports.h"
+
+// a duration of d microseconds is counted in the histogram bucket
+// floor(log2(d + 1))
+#define PROFILE_BUCKET_COUNT 32
+
+typedef struct HSProfileCounter HSProfileCounter;
+
+// the begin of a measurement
+typedef struct {
+    gint64          time;       // 0 if profiling is disabled
+    unsigned long   request;    // serial number of the next X request
+} HSProfileStart;
+
+extern bool g_profile_enabled;
+extern HSProfileCounter* g_profile_layout;
+extern HSProfileCounter* g_profile_rules;
+extern HSProfileCounter* g_profile_resize_outline;
+
+void profile_init();
+void profile_destroy();
+
+// measurements cost nearly nothing if profile.enabled is unset
+HSProfileStart profile_begin();
+void profile_end(HSProfileCounter* counter, HSProfileStart start);
+void profile_end_command(const char* name, HSProfileStart start);
+void profile_end_event(int type, HSProfileStart start);
+
+int profile_command(int argc, char** argv, GString* output);
+
+#endif
+
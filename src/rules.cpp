@@ -11,6 +11,7 @@
 #include "ipc-protocol.h"
 #include "hook.h"
 #include "command.h"
+#include "profile.h"
 
 #include "glib-backports.h"
 #include "glib-backports.h"
@@ -99,16 +100,147 @@ static HSConsequenceType g_consequence_types[] = {
 
 static GQueue g_rules = G_QUEUE_INIT; // a list of HSRule* elements
 
+// The rules are indexed by their first exact class or instance condition.
+// Each index maps the condition value to a GQueue of HSRule*; all rules
+// without such a condition and rules with a maxage condition (which must be
+// evaluated for every client) are in g_rules_unindexed. All these lists are
+// sorted by HSRule.order, just like g_rules.
+static GHashTable* g_rules_by_class; // value -> GQueue* of HSRule*
+static GHashTable* g_rules_by_instance; // value -> GQueue* of HSRule*
+static GQueue g_rules_unindexed = G_QUEUE_INIT;
+static long long g_rule_order_head; // order of the first rule in g_rules
+static long long g_rule_order_tail; // order of the last rule in g_rules
+static int g_class_type; // index of "class"
+static int g_instance_type; // index of "instance"
+
 /// FUNCTIONS ///
 // RULES //
 void rules_init() {
     g_maxage_type = find_condition_type("maxage");
+    g_class_type = find_condition_type("class");
+    g_instance_type = find_condition_type("instance");
     g_rule_label_index = 0;
+    g_rule_order_head = 0;
+    g_rule_order_tail = 0;
+    g_rules_by_class = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                g_free, (GDestroyNotify)g_queue_free);
+    g_rules_by_instance = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                g_free, (GDestroyNotify)g_queue_free);
 }
 
-void rules_destroy() {
+static void rules_clear() {
     g_queue_foreach(&g_rules, (GFunc)rule_destroy, NULL);
     g_queue_clear(&g_rules);
+    g_hash_table_remove_all(g_rules_by_class);
+    g_hash_table_remove_all(g_rules_by_instance);
+    g_queue_clear(&g_rules_unindexed);
+}
+
+void rules_destroy() {
+    rules_clear();
+    g_hash_table_destroy(g_rules_by_class);
+    g_hash_table_destroy(g_rules_by_instance);
+}
+
+// rule index //
+static GHashTable* rule_index_table(HSCondition* cond) {
+    return (cond->condition_type == g_class_type)
+        ? g_rules_by_class : g_rules_by_instance;
+}
+
+static HSCondition* rule_find_index_condition(HSRule* rule) {
+    HSCondition* found = NULL;
+    for (int i = 0; i < rule->condition_count; i++) {
+        HSCondition* cond = rule->conditions[i];
+        if (cond->condition_type == g_maxage_type) {
+            // maxage may expire the rule, so it must always be evaluated
+            return NULL;
+        }
+        if (!found && !cond->negated
+            && cond->value_type == CONDITION_VALUE_TYPE_STRING
+            && (cond->condition_type == g_class_type
+                || cond->condition_type == g_instance_type)) {
+            found = cond;
+        }
+    }
+    return found;
+}
+
+// returns the index list the rule belongs to, creates it if needed
+static GQueue* rule_index_queue(HSRule* rule) {
+    HSCondition* cond = rule->index_condition;
+    if (!cond) {
+        return &g_rules_unindexed;
+    }
+    GHashTable* table = rule_index_table(cond);
+    GQueue* queue = (GQueue*)g_hash_table_lookup(table, cond->value.str);
+    if (!queue) {
+        queue = g_queue_new();
+        g_hash_table_insert(table, g_strdup(cond->value.str), queue);
+    }
+    return queue;
+}
+
+// inserts a new rule at the beginning or the end of the rule list
+static void rules_insert(HSRule* rule, bool prepend) {
+    rule->index_condition = rule_find_index_condition(rule);
+    GQueue* queue = rule_index_queue(rule);
+    if (prepend) {
+        rule->order = --g_rule_order_head;
+        g_queue_push_head(&g_rules, rule);
+        g_queue_push_head(queue, rule);
+    } else {
+        rule->order = ++g_rule_order_tail;
+        g_queue_push_tail(&g_rules, rule);
+        g_queue_push_tail(queue, rule);
+    }
+}
+
+// removes the rule from the rule list and destroys it
+static void rules_remove(HSRule* rule) {
+    HSCondition* cond = rule->index_condition;
+    GQueue* queue = rule_index_queue(rule);
+    g_queue_remove(queue, rule);
+    if (cond && g_queue_is_empty(queue)) {
+        g_hash_table_remove(rule_index_table(cond), cond->value.str);
+    }
+    g_queue_remove(&g_rules, rule);
+    rule_destroy(rule);
+}
+
+// collects the rules that possibly match the client, in rule order
+static GArray* rules_candidates(HSClient* client) {
+    GList* lists[] = {
+        g_rules_unindexed.head,
+        NULL,
+        NULL,
+    };
+    GQueue* queue;
+    queue = (GQueue*)g_hash_table_lookup(g_rules_by_class,
+                                         client->window_class->str);
+    lists[1] = queue ? queue->head : NULL;
+    queue = (GQueue*)g_hash_table_lookup(g_rules_by_instance,
+                                         client->window_instance->str);
+    lists[2] = queue ? queue->head : NULL;
+    GArray* candidates = g_array_new(false, false, sizeof(HSRule*));
+    while (true) {
+        // merge the sorted lists
+        int min = -1;
+        for (int i = 0; i < LENGTH(lists); i++) {
+            if (lists[i] && (min < 0 ||
+                ((HSRule*)lists[i]->data)->order
+                    < ((HSRule*)lists[min]->data)->order)) {
+                min = i;
+            }
+        }
+        if (min < 0) {
+            break;
+        }
+        HSRule* rule = (HSRule*)lists[min]->data;
+        g_array_append_val(candidates, rule);
+        lists[min] = lists[min]->next;
+    }
+    return candidates;
 }
 
 // condition types //
@@ -338,10 +470,8 @@ static bool rule_find_pop(char* label) {
             break;
         }
         status = true;
-        // If so, clear data
-        rule_destroy((HSRule*)rule->data);
-        // Remove and free empty link
-        g_queue_delete_link(&g_rules, rule);
+        // If so, remove it
+        rules_remove((HSRule*)rule->data);
     }
     return status;
 }
@@ -516,8 +646,7 @@ int rule_add_command(int argc, char** argv, GString* output) {
        g_string_append_printf(output, "%s\n", rule->label);
     }
 
-    if (prepend) g_queue_push_head(&g_rules, rule);
-    else         g_queue_push_tail(&g_rules, rule);
+    rules_insert(rule, prepend);
     return 0;
 }
 
@@ -544,8 +673,7 @@ int rule_remove_command(int argc, char** argv, GString* output) {
 
     if (!strcmp(argv[1], "--all") || !strcmp(argv[1], "-F")) {
         // remove all rules
-        g_queue_foreach(&g_rules, (GFunc)rule_destroy, NULL);
-        g_queue_clear(&g_rules);
+        rules_clear();
         g_rule_label_index = 0;
         return 0;
     }
@@ -584,9 +712,12 @@ void client_changes_free_members(HSClientChanges* changes) {
 
 // apply all rules to a certain client an save changes
 void rules_apply(HSClient* client, HSClientChanges* changes) {
-    GList* cur = g_rules.head;
-    while (cur) {
-        HSRule* rule = (HSRule*)cur->data;
+    HSProfileStart start = profile_begin();
+    // only the rules from the index can match, all others have an exact
+    // class or instance condition that does not match
+    GArray* candidates = rules_candidates(client);
+    for (int r = 0; r < candidates->len; r++) {
+        HSRule* rule = g_array_index(candidates, HSRule*, r);
         bool matches = true;    // if current condition matches
         bool rule_match = true; // if entire rule matches
         bool rule_expired = false;
@@ -630,16 +761,11 @@ void rules_apply(HSClient* client, HSClientChanges* changes) {
 
         // remove it if not wanted or needed anymore
         if ((rule_match && rule->once) || rule_expired) {
-            GList* next = cur->next;
-            rule_destroy((HSRule*)cur->data);
-            g_queue_remove_element(&g_rules, cur);
-            cur = next;
-            continue;
+            rules_remove(rule);
         }
-
-        // try next
-        cur = cur ? cur->next : NULL;
     }
+    g_array_free(candidates, true);
+    profile_end(g_profile_rules, start);
 }
 
 /// CONDITIONS ///
@@ -675,17 +801,11 @@ static bool condition_string(HSCondition* rule, const char* string) {
 }
 
 static bool condition_class(HSCondition* rule, HSClient* client) {
-    GString* window_class = window_class_to_g_string(g_display, client->window);
-    bool match = condition_string(rule, window_class->str);
-    g_string_free(window_class, true);
-    return match;
+    return condition_string(rule, client->window_class->str);
 }
 
 static bool condition_instance(HSCondition* rule, HSClient* client) {
-    GString* inst = window_instance_to_g_string(g_display, client->window);
-    bool match = condition_string(rule, inst->str);
-    g_string_free(inst, true);
-    return match;
+    return condition_string(rule, client->window_instance->str);
 }
 
 static bool condition_title(HSCondition* rule, HSClient* client) {
@@ -711,7 +831,7 @@ static bool condition_maxage(HSCondition* rule, HSClient* client) {
 }
 
 static bool condition_windowtype(HSCondition* rule, HSClient* client) {
-    int windowtype = ewmh_get_window_type(client->window);
+    int windowtype = client->window_type;
     if (windowtype < 0) {
         return false;
     } else {
@@ -723,12 +843,8 @@ static bool condition_windowtype(HSCondition* rule, HSClient* client) {
 }
 
 static bool condition_windowrole(HSCondition* rule, HSClient* client) {
-    GString* role = window_property_to_g_string(g_display, client->window,
-        ATOM("WM_WINDOW_ROLE"));
-    if (!role) return false;
-    bool match = condition_string(rule, role->str);
-    g_string_free(role, true);
-    return match;
+    if (!client->window_role) return false;
+    return condition_string(rule, client->window_role->str);
 }
 
 /// CONSEQUENCES ///
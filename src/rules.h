@@ -53,6 +53,8 @@ typedef struct {
     int             consequence_count;
     bool            once;
     time_t          birth_time; // timestamp of at creation
+    long long       order; // position in the rule list, ascending
+    HSCondition*    index_condition; // condition it is indexed by, or NULL
 } HSRule;
 
 typedef struct {
@@ -94,6 +94,8 @@ SettingsPair g_settings[] = {
     SET_INT(    "auto_detect_monitors",            0,           NULL          ),
     SET_INT(    "pseudotile_center_threshold",    10,           RELAYOUT      ),
     SET_INT(    "update_dragged_clients",          0,           NULL          ),
+    SET_INT(    "drag_update_rate",               60,           NULL          ),
+    SET_INT(    "hook_coalesce_interval",          0,           NULL          ),
     SET_STRING( "tree_style",                      "*| +`--.",  reload_tree_style),
     SET_STRING( "wmname",                  WINDOW_MANAGER_NAME, WMNAME        ),
     // settings for compatibility:
@@ -29,16 +29,25 @@ void stacklist_destroy() {
 
 
 HSStack* stack_create() {
-    return g_new0(HSStack, 1);
+    HSStack* s = g_new0(HSStack, 1);
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        s->layer[i].slices = g_array_new(false, false, sizeof(HSSlice*));
+    }
+    s->windows = g_array_new(false, false, sizeof(Window));
+    s->dirty = true;
+    s->windows_dirty = true;
+    return s;
 }
 
 void stack_destroy(HSStack* s) {
     for (int i = 0; i < LAYER_COUNT; i++) {
-        if (s->top[i]) {
+        if (s->layer[i].count) {
             HSDebug("Warning: %s of stack %p was not empty on destroy\n",
                     g_layer_names[i], (void*)s);
         }
+        g_array_free(s->layer[i].slices, true);
     }
+    g_array_free(s->windows, true);
     g_free(s);
 }
 
@@ -91,20 +100,66 @@ HSLayer slice_highest_layer(HSSlice* slice) {
     return highest;
 }
 
+static HSSlice* layer_slice(HSStackLayer* l, size_t idx) {
+    return g_array_index(l->slices, HSSlice*, idx);
+}
+
+/* puts the slice on top of the layer */
+static void layer_push(HSStack* s, HSLayer layer, HSSlice* slice) {
+    HSStackLayer* l = s->layer + layer;
+    slice->index[layer] = l->slices->len;
+    g_array_append_val(l->slices, slice);
+    l->count++;
+}
+
+static void layer_compact(HSStack* s, HSLayer layer) {
+    HSStackLayer* l = s->layer + layer;
+    size_t used = 0;
+    for (size_t i = 0; i < l->slices->len; i++) {
+        HSSlice* slice = layer_slice(l, i);
+        if (slice) {
+            slice->index[layer] = used;
+            g_array_index(l->slices, HSSlice*, used) = slice;
+            used++;
+        }
+    }
+    g_array_set_size(l->slices, used);
+}
+
+/* removes the slice from the layer. It only leaves a gap, which is removed
+ * if it is at the top or if there are too many gaps. */
+static bool layer_remove(HSStack* s, HSLayer layer, HSSlice* slice) {
+    HSStackLayer* l = s->layer + layer;
+    size_t idx = slice->index[layer];
+    if (idx >= l->slices->len || layer_slice(l, idx) != slice) {
+        // slice is not in this layer
+        return false;
+    }
+    g_array_index(l->slices, HSSlice*, idx) = NULL;
+    l->count--;
+    size_t len = l->slices->len;
+    while (len > 0 && !layer_slice(l, len - 1)) {
+        len--;
+    }
+    g_array_set_size(l->slices, len);
+    if (len > 2 * l->count + 16) {
+        layer_compact(s, layer);
+    }
+    return true;
+}
+
 void stack_insert_slice(HSStack* s, HSSlice* elem) {
     for (int i = 0; i < elem->layer_count; i++) {
-        int layer = elem->layer[i];
-        s->top[layer] = g_list_prepend(s->top[layer], elem);
+        layer_push(s, elem->layer[i], elem);
     }
-    s->dirty = true;
+    stack_mark_dirty(s);
 }
 
 void stack_remove_slice(HSStack* s, HSSlice* elem) {
     for (int i = 0; i < elem->layer_count; i++) {
-        int layer = elem->layer[i];
-        s->top[layer] = g_list_remove(s->top[layer], elem);
+        layer_remove(s, elem->layer[i], elem);
     }
-    s->dirty = true;
+    stack_mark_dirty(s);
 }
 
 static void slice_append_caption(HSTree root, GString* output) {
@@ -156,7 +211,14 @@ struct TmpLayer {
 
 static struct HSTreeInterface layer_nth_child(HSTree root, size_t idx) {
     struct TmpLayer* l = (struct TmpLayer*) root;
-    HSSlice* slice = (HSSlice*) g_list_nth_data(l->stack->top[l->layer], idx);
+    HSStackLayer* layer = l->stack->layer + l->layer;
+    HSSlice* slice = NULL;
+    for (size_t i = layer->slices->len; i > 0; i--) {
+        slice = layer_slice(layer, i - 1);
+        if (slice && idx-- == 0) {
+            break;
+        }
+    }
     HSTreeInterface intface = {
         /* .nth_child      = */ slice_nth_child,
         /* .child_count    = */ slice_child_count,
@@ -169,7 +231,7 @@ static struct HSTreeInterface layer_nth_child(HSTree root, size_t idx) {
 
 static size_t layer_child_count(HSTree root) {
     struct TmpLayer* l = (struct TmpLayer*) root;
-    return g_list_length(l->stack->top[l->layer]);
+    return l->stack->layer[l->layer].count;
 }
 
 static void layer_append_caption(HSTree root, GString* output) {
@@ -217,130 +279,154 @@ int print_stack_command(int argc, char** argv, GString* output) {
     return 0;
 }
 
-int stack_window_count(HSStack* stack, bool real_clients) {
-    int counter = 0;
-    stack_to_window_buf(stack, NULL, 0, real_clients, &counter);
-    return -counter;
+void stack_append_windows(HSStack* stack, GArray* windows, bool real_clients) {
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        HSStackLayer* l = stack->layer + i;
+        for (size_t j = l->slices->len; j > 0; j--) {
+            HSSlice* s = layer_slice(l, j - 1);
+            if (!s || slice_highest_layer(s) != i) {
+                /** slice only is added to its highest layer.
+                 * just skip it if the slice is not shown on this layer */
+                continue;
+            }
+            switch (s->type) {
+                case SLICE_CLIENT:
+                    if (real_clients) {
+                        g_array_append_val(windows, s->data.client->window);
+                    } else {
+                        g_array_append_val(windows, s->data.client->dec.decwin);
+                    }
+                    break;
+                case SLICE_WINDOW:
+                    if (!real_clients) {
+                        g_array_append_val(windows, s->data.window);
+                    }
+                    break;
+                case SLICE_MONITOR:
+                    if (!real_clients) {
+                        g_array_append_val(windows,
+                                           s->data.monitor->stacking_window);
+                    }
+                    stack_append_windows(s->data.monitor->tag->stack, windows,
+                                         real_clients);
+                    break;
+            }
+        }
+    }
 }
 
-/* stack to window buf */
-struct s2wb {
-    int     len;
-    Window* buf;
-    int     missing; /* number of slices that could not find space in buf */
-    bool    real_clients; /* whether to include windows that aren't clients */
-    HSLayer layer;  /* the layer the slice should be added to */
-};
+GArray* stack_windows(HSStack* stack) {
+    if (stack->windows_dirty) {
+        g_array_set_size(stack->windows, 0);
+        stack_append_windows(stack, stack->windows, false);
+        stack->windows_dirty = false;
+    }
+    return stack->windows;
+}
 
-static void slice_to_window_buf(HSSlice* s, struct s2wb* data) {
-    HSTag* tag;
-    if (slice_highest_layer(s) != data->layer) {
-        /** slice only is added to its highest layer.
-         * just skip it if the slice is not shown on this data->layer */
+void stack_restack_windows(GArray* restacked, Window* windows, size_t count) {
+    Window* old = &g_array_index(restacked, Window, 0);
+    size_t old_count = restacked->len;
+    if (old_count == count && !memcmp(old, windows, sizeof(Window) * count)) {
+        // nothing changed
         return;
     }
-    switch (s->type) {
-        case SLICE_CLIENT:
-            if (data->len) {
-                if (data->real_clients) {
-                    data->buf[0] = s->data.client->window;
-                } else {
-                    data->buf[0] = s->data.client->dec.decwin;
-                }
-                data->buf++;
-                data->len--;
-            } else {
-                data->missing++;
+    if (count == 0) {
+        // nothing to restack
+    } else if (old_count == 0 || old[0] != windows[0]) {
+        XRestackWindows(g_display, windows, count);
+    } else {
+        // the windows that keep their position are the longest subsequence
+        // whose old positions are increasing. all others are moved directly
+        // below their new upper neighbour.
+        GHashTable* old_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (size_t i = 0; i < old_count; i++) {
+            g_hash_table_insert(old_index, GSIZE_TO_POINTER(old[i]),
+                                GSIZE_TO_POINTER(i + 1));
+        }
+        // index in windows of the last element of the best subsequence of
+        // length k + 1 found so far
+        size_t* tail = g_new(size_t, count);
+        // the predecessor of each window in its subsequence
+        size_t* pred = g_new(size_t, count);
+        // the old position of each window + 1, 0 for new windows
+        size_t* pos = g_new(size_t, count);
+        size_t length = 0;
+        for (size_t i = 0; i < count; i++) {
+            pos[i] = GPOINTER_TO_SIZE(g_hash_table_lookup(old_index,
+                                      GSIZE_TO_POINTER(windows[i])));
+            if (pos[i] == 0) {
+                continue;
             }
-            break;
-        case SLICE_WINDOW:
-            if (!data->real_clients) {
-                if (data->len) {
-                    data->buf[0] = s->data.window;
-                    data->buf++;
-                    data->len--;
+            size_t lo = 0, hi = length;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (pos[tail[mid]] < pos[i]) {
+                    lo = mid + 1;
                 } else {
-                    data->missing++;
+                    hi = mid;
                 }
             }
-            break;
-        case SLICE_MONITOR:
-            tag = s->data.monitor->tag;
-            if (!data->real_clients) {
-                if (data->len) {
-                    data->buf[0] = s->data.monitor->stacking_window;
-                    data->buf++;
-                    data->len--;
-                } else {
-                    data->missing++;
-                }
+            pred[i] = (lo > 0) ? tail[lo - 1] : i;
+            tail[lo] = i;
+            if (lo == length) {
+                length++;
             }
-            int remain_len = 0; /* remaining length */
-            stack_to_window_buf(tag->stack, data->buf, data->len,
-                                data->real_clients, &remain_len);
-            int len_used = data->len - remain_len;
-            if (remain_len >= 0) {
-                data->buf += len_used;
-                data->len = remain_len;
-            } else {
-                data->len = 0;
-                data->missing += -remain_len;
+        }
+        // windows[0] starts every subsequence because its old position is
+        // the lowest, so it is kept, too
+        bool* keep = g_new0(bool, count);
+        for (size_t i = tail[length - 1]; !keep[i]; i = pred[i]) {
+            keep[i] = true;
+        }
+        XWindowChanges wc;
+        wc.stack_mode = Below;
+        for (size_t i = 1; i < count; i++) {
+            if (!keep[i]) {
+                wc.sibling = windows[i - 1];
+                XConfigureWindow(g_display, windows[i],
+                                 CWSibling | CWStackMode, &wc);
             }
-            break;
-    }
-}
-
-void stack_to_window_buf(HSStack* stack, Window* buf, int len,
-                         bool real_clients, int* remain_len) {
-    struct s2wb data = {
-        /* .len = */ len,
-        /* .buf = */ buf,
-        /* .missing = */ 0,
-        /* .real_clients = */ real_clients,
-    };
-    for (int i = 0; i < LAYER_COUNT; i++) {
-        data.layer = (HSLayer)i;
-        g_list_foreach(stack->top[i], (GFunc)slice_to_window_buf, &data);
-    }
-    if (!remain_len) {
-        // nothing to do
-        return;
-    }
-    if (data.missing == 0) {
-        *remain_len = data.len;
-    } else {
-        *remain_len = -data.missing;
+        }
+        g_free(keep);
+        g_free(tail);
+        g_free(pred);
+        g_free(pos);
+        g_hash_table_destroy(old_index);
     }
+    g_array_set_size(restacked, 0);
+    g_array_append_vals(restacked, windows, count);
 }
 
 void stack_restack(HSStack* stack) {
     if (!stack->dirty) {
         return;
     }
-    int count = stack_window_count(stack, false);
-    Window* buf = g_new0(Window, count);
-    stack_to_window_buf(stack, buf, count, false, NULL);
-    XRestackWindows(g_display, buf, count);
+    GArray* buf = g_array_new(false, false, sizeof(Window));
+    stack_append_windows(stack, buf, false);
+    XRestackWindows(g_display, &g_array_index(buf, Window, 0), buf->len);
     stack->dirty = false;
     ewmh_update_client_list_stacking();
-    g_free(buf);
+    g_array_free(buf, true);
 }
 
 void stack_raise_slide(HSStack* stack, HSSlice* slice) {
     for (int i = 0; i < slice->layer_count; i++) {
-        // remove slice from list
-        stack->top[slice->layer[i]] = g_list_remove(stack->top[slice->layer[i]], slice);
-        // and insert it again at the top
-        stack->top[slice->layer[i]] = g_list_prepend(stack->top[slice->layer[i]], slice);
+        HSLayer layer = slice->layer[i];
+        if (slice->index[layer] + 1 == stack->layer[layer].slices->len) {
+            // already on top
+            continue;
+        }
+        // remove slice from the layer and insert it again at the top
+        layer_remove(stack, layer, slice);
+        layer_push(stack, layer, slice);
+        stack_mark_dirty(stack);
     }
-    stack->dirty = true;
-    // TODO: maybe only update the specific range and not the entire stack
-    // update
-    stack_restack(stack);
 }
 
 void stack_mark_dirty(HSStack* s) {
     s->dirty = true;
+    s->windows_dirty = true;
 }
 
 void stack_slice_add_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
@@ -352,8 +438,8 @@ void stack_slice_add_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
     }
     slice->layer[slice->layer_count] = layer;
     slice->layer_count++;
-    stack->top[layer] = g_list_prepend(stack->top[layer], slice);
-    stack->dirty = true;
+    layer_push(stack, layer, slice);
+    stack_mark_dirty(stack);
 }
 
 void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
@@ -364,8 +450,8 @@ void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
         }
     }
     /* remove slice from layer in the stack */
-    stack->top[layer] = g_list_remove(stack->top[layer], slice);
-    stack->dirty = true;
+    layer_remove(stack, layer, slice);
+    stack_mark_dirty(stack);
     if (i >= slice->layer_count) {
         HSDebug("remove layer: slice %p not in %s\n", (void*)slice,
                 g_layer_names[layer]);
@@ -379,9 +465,12 @@ void stack_slice_remove_layer(HSStack* stack, HSSlice* slice, HSLayer layer) {
 
 Window stack_lowest_window(HSStack* stack) {
     for (int i = LAYER_COUNT - 1; i >= 0; i--) {
-        GList* last = g_list_last(stack->top[i]);
-        while (last) {
-            HSSlice* slice = (HSSlice*)last->data;
+        HSStackLayer* l = stack->layer + i;
+        for (size_t j = 0; j < l->slices->len; j++) {
+            HSSlice* slice = layer_slice(l, j);
+            if (!slice) {
+                continue;
+            }
             Window w = 0;
             switch (slice->type) {
                 case SLICE_CLIENT:
@@ -397,7 +486,6 @@ Window stack_lowest_window(HSStack* stack) {
             if (w) {
                 return w;
             }
-            last = g_list_previous(last);
         }
     }
     // if no window was found
@@ -405,14 +493,16 @@ Window stack_lowest_window(HSStack* stack) {
 }
 
 bool stack_is_layer_empty(HSStack* s, HSLayer layer) {
-    return s->top[layer] == NULL;
+    return s->layer[layer].count == 0;
 }
 
 void stack_clear_layer(HSStack* stack, HSLayer layer) {
     while (!stack_is_layer_empty(stack, layer)) {
-        HSSlice* slice = (HSSlice*)stack->top[layer]->data;
+        HSStackLayer* l = stack->layer + layer;
+        // the top of a layer is never a gap
+        HSSlice* slice = layer_slice(l, l->slices->len - 1);
         stack_slice_remove_layer(stack, slice, layer);
-        stack->dirty = true;
+        stack_mark_dirty(stack);
     }
 }
 
@@ -35,6 +35,7 @@ typedef struct HSSlice {
     HSSliceType type;
     HSLayer     layer[LAYER_COUNT]; /* layers this slice is contained in */
     size_t      layer_count;        /* count of those layers */
+    size_t      index[LAYER_COUNT]; /* position in the HSStackLayer arrays */
     union {
         struct HSClient*    client;
         Window              window;
@@ -42,9 +43,16 @@ typedef struct HSSlice {
     } data;
 } HSSlice;
 
+typedef struct HSStackLayer {
+    GArray* slices; /* HSSlice* from bottom to top, NULL for removed slices */
+    size_t  count;  /* number of slices in this layer */
+} HSStackLayer;
+
 typedef struct HSStack {
-    GList*  top[LAYER_COUNT];
+    HSStackLayer layer[LAYER_COUNT];
     bool    dirty;  /* stacking order changed but it wasn't restacked yet */
+    GArray* windows;        /* cached result of stack_windows() */
+    bool    windows_dirty;  /* whether windows is outdated */
 } HSStack;
 
 void stacklist_init();
@@ -68,10 +76,17 @@ void stack_clear_layer(HSStack* stack, HSLayer layer);
 
 int print_stack_command(int argc, char** argv, GString* output);
 
-// returns the number of windows in this stack
-int stack_window_count(HSStack* stack, bool real_clients);
-void stack_to_window_buf(HSStack* stack, Window* buf, int len, bool real_clients,
-                         int* remain_len);
+// appends the windows of the stack from top to bottom to the GArray of
+// Windows. If real_clients is set, only the client windows are added,
+// otherwise the windows to restack (decorations, frames and monitors)
+void stack_append_windows(HSStack* stack, GArray* windows, bool real_clients);
+// returns the windows to restack from top to bottom. The array is cached until
+// the stack changes, so do not use it for stacks containing monitors.
+GArray* stack_windows(HSStack* stack);
+// restacks the windows (top to bottom) below the first one by moving only
+// those that changed their relative position since the last call on the same
+// restacked array, which is updated to the new order afterwards.
+void stack_restack_windows(GArray* restacked, Window* windows, size_t count);
 void stack_restack(HSStack* stack);
 Window stack_lowest_window(HSStack* stack);
 
@@ -21,7 +21,7 @@
 #include "settings.h"
 
 static GArray*     g_tags; // Array of HSTag*
-static bool    g_tag_flags_dirty = true;
+static bool    g_tag_flags_changed = false;
 static HSObject* g_tag_object;
 static HSObject* g_tag_by_name;
 static int* g_raise_on_focus_temporarily;
@@ -51,6 +51,7 @@ static void tag_free(HSTag* tag) {
         }
     }
     stack_destroy(tag->stack);
+    rectindex_destroy(tag->rects);
     hsobject_unlink_and_destroy(g_tag_by_name, tag->object);
     g_string_free(tag->name, true);
     g_string_free(tag->display_name, true);
@@ -174,17 +175,9 @@ static int tag_attr_frame_count(void* data) {
     return i;
 }
 
-static void sum_up_clients(HSFrame* frame, void* data) {
-    if (frame->type == TYPE_CLIENTS) {
-        *(int*)data += frame->content.clients.count;
-    }
-}
-
 static int tag_attr_client_count(void* data) {
     HSTag* tag = (HSTag*) data;
-    int i = 0;
-    frame_do_recursive_data(tag->frame, sum_up_clients, 0, &i);
-    return i;
+    return tag->client_count;
 }
 
 
@@ -227,6 +220,7 @@ HSTag* add_tag(const char* name) {
     }
     HSTag* tag = g_new0(HSTag, 1);
     tag->stack = stack_create();
+    tag->rects = rectindex_create();
     tag->frame = frame_create_empty(NULL, tag);
     tag->name = g_string_new(name);
     tag->display_name = g_string_new(name);
@@ -251,7 +245,6 @@ HSTag* add_tag(const char* name) {
 
     ewmh_update_desktops();
     ewmh_update_desktop_names();
-    tag_set_flags_dirty();
     return tag;
 }
 
@@ -347,8 +340,12 @@ int tag_remove_command(int argc, char** argv, GString* output) {
     for (i = 0; i < count; i++) {
         HSClient* client = buf[i];
         stack_remove_slice(client->tag->stack, client->slice);
+        rectindex_remove(client->tag->rects, client);
+        tag_flags_remove_client(client->tag, client);
         client->tag = target;
         stack_insert_slice(client->tag->stack, client->slice);
+        rectindex_insert(client->tag->rects, client);
+        tag_flags_add_client(client->tag, client);
         ewmh_window_update_tag(client->window, client->tag);
         frame_insert_client(target->frame, buf[i]);
     }
@@ -376,7 +373,6 @@ int tag_remove_command(int argc, char** argv, GString* output) {
     ewmh_update_desktop_names();
     clientlist_foreach(client_update_tag, NULL);
     tag_update_focus_objects();
-    tag_set_flags_dirty();
     hook_emit_list("tag_removed", oldname, target->name->str, NULL);
     g_free(oldname);
     tag_foreach(tag_link_id_object, NULL);
@@ -416,37 +412,70 @@ int tag_set_floating_command(int argc, char** argv, GString* output) {
     return 0;
 }
 
-static void client_update_tag_flags(void* key, void* client_void, void* data) {
-    (void) key;
-    (void) data;
-    HSClient* client = (HSClient*)client_void;
-    if (client) {
-        TAG_SET_FLAG(client->tag, TAG_FLAG_USED);
-        if (client->urgent) {
-            TAG_SET_FLAG(client->tag, TAG_FLAG_URGENT);
-        }
+static void tag_update_flags(HSTag* tag) {
+    int flags = 0;
+    if (tag->client_count > 0) {
+        flags |= TAG_FLAG_USED;
+    }
+    if (tag->urgent_count > 0) {
+        flags |= TAG_FLAG_URGENT;
+    }
+    tag->flags = flags;
+    if (tag->flags != tag->reported_flags) {
+        g_tag_flags_changed = true;
     }
 }
 
-void tag_force_update_flags() {
-    g_tag_flags_dirty = false;
-    // unset all tags
-    for (int i = 0; i < g_tags->len; i++) {
-        g_array_index(g_tags, HSTag*, i)->flags = 0;
+void tag_flags_add_client(HSTag* tag, HSClient* client) {
+    tag->client_count++;
+    if (client->urgent_counted) {
+        tag->urgent_count++;
     }
-    // update flags
-    clientlist_foreach(client_update_tag_flags, NULL);
+    tag_update_flags(tag);
 }
 
-void tag_update_flags() {
-    if (g_tag_flags_dirty) {
-        tag_force_update_flags();
+void tag_flags_remove_client(HSTag* tag, HSClient* client) {
+    tag->client_count--;
+    if (client->urgent_counted) {
+        tag->urgent_count--;
     }
+    tag_update_flags(tag);
 }
 
-void tag_set_flags_dirty() {
-    g_tag_flags_dirty = true;
-    hook_emit_list("tag_flags", NULL);
+void tag_flags_update_urgent(HSClient* client) {
+    // the urgent attribute toggles client->urgent before setting it, so only
+    // rely on what was counted for this client
+    if (client->urgent == client->urgent_counted) {
+        return;
+    }
+    client->urgent_counted = client->urgent;
+    if (client->tag && client->slice) {
+        // the client is counted on its tag
+        client->tag->urgent_count += client->urgent ? 1 : -1;
+        tag_update_flags(client->tag);
+    }
+}
+
+void tag_flush_flags() {
+    if (!g_tag_flags_changed) {
+        return;
+    }
+    g_tag_flags_changed = false;
+    // the hook name and the names of all changed tags
+    const char** argv = g_new(const char*, g_tags->len + 1);
+    int argc = 0;
+    argv[argc++] = "tag_flags";
+    for (int i = 0; i < g_tags->len; i++) {
+        HSTag* tag = g_array_index(g_tags, HSTag*, i);
+        if (tag->flags != tag->reported_flags) {
+            tag->reported_flags = tag->flags;
+            argv[argc++] = tag->name->str;
+        }
+    }
+    if (argc > 1) {
+        hook_emit(argc, argv);
+    }
+    g_free(argv);
 }
 
 void ensure_tags_are_available() {
@@ -523,8 +552,12 @@ void tag_move_client(HSClient* client, HSTag* target) {
     // enfoce it to be focused on the target tag
     frame_focus_client(target->frame, client);
     stack_remove_slice(client->tag->stack, client->slice);
+    rectindex_remove(client->tag->rects, client);
+    tag_flags_remove_client(client->tag, client);
     client->tag = target;
     stack_insert_slice(client->tag->stack, client->slice);
+    rectindex_insert(client->tag->rects, client);
+    tag_flags_add_client(client->tag, client);
     ewmh_window_update_tag(client->window, client->tag);
 
     // refresh things, hide things, layout it, and then show it if needed
@@ -544,7 +577,6 @@ void tag_move_client(HSClient* client, HSTag* target) {
     else if (monitor_source == get_current_monitor()) {
         frame_focus_recursive(monitor_source->tag->frame);
     }
-    tag_set_flags_dirty();
 }
 
 void tag_update_focus_layer(HSTag* tag) {
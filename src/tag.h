@@ -12,6 +12,7 @@
 struct HSFrame;
 struct HSClient;
 struct HSStack;
+struct HSRectIndex;
 
 typedef struct HSTag {
     GString*        name;   // name of this tag
@@ -19,7 +20,11 @@ typedef struct HSTag {
     struct HSFrame* frame;  // the master frame
     bool            floating;
     int             flags;
+    int             reported_flags; // flags of the last tag_flags hook
+    int             client_count;   // clients on this tag
+    int             urgent_count;   // urgent clients on this tag
     struct HSStack* stack;
+    struct HSRectIndex* rects; // outer rects of the clients of this tag
     struct HSObject* object;
 } HSTag;
 
@@ -47,9 +52,13 @@ void tag_update_focus_layer(HSTag* tag);
 void tag_foreach(void (*action)(HSTag*,void*), void* data);
 void tag_update_each_focus_layer();
 void tag_update_focus_objects();
-void tag_force_update_flags();
-void tag_update_flags();
-void tag_set_flags_dirty();
+// update the client counters and thus the flags of a tag
+void tag_flags_add_client(HSTag* tag, struct HSClient* client);
+void tag_flags_remove_client(HSTag* tag, struct HSClient* client);
+// to be called whenever client->urgent was changed
+void tag_flags_update_urgent(struct HSClient* client);
+// emits tag_flags for the tags whose flags changed since the last call
+void tag_flush_flags();
 void ensure_tags_are_available();
 
 #endif
@@ -6,6 +6,7 @@
 #include "globals.h"
 #include "utils.h"
 #include "settings.h"
+#include "ipc-protocol.h"
 // standard
 #include <stdarg.h>
 #include <stdio.h>
@@ -28,6 +29,62 @@
 
 // globals
 static const char*   g_tree_style = "                "; /* the one from layout.c */
+static GHashTable*   g_atoms = NULL; // maps atom names to atoms
+
+// atoms that are looked up with ATOM() during normal operation
+static const char* g_prefetched_atoms[] = {
+    HERBST_IPC_ARGS_ATOM,
+    HERBST_IPC_OUTPUT_ATOM,
+    HERBST_IPC_STATUS_ATOM,
+    HERBST_HOOK_WIN_ID_ATOM,
+    "UTF8_STRING",
+    "ATOM",
+    "WM_WINDOW_ROLE",
+    "WM_PROTOCOLS",
+    "WM_DELETE_WINDOW",
+    "WM_STATE",
+    "WM_TAKE_FOCUS",
+    "_NET_WM_PID",
+};
+
+void atoms_init() {
+    g_atoms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    // the known atom names and the properties of the hook ring are
+    // interned with a single request
+    int count = LENGTH(g_prefetched_atoms) + HERBST_HOOK_PROPERTY_COUNT;
+    char** names = g_new(char*, count);
+    Atom* atoms = g_new(Atom, count);
+    int i;
+    for (i = 0; i < LENGTH(g_prefetched_atoms); i++) {
+        names[i] = g_strdup(g_prefetched_atoms[i]);
+    }
+    for (int j = 0; j < HERBST_HOOK_PROPERTY_COUNT; j++, i++) {
+        names[i] = g_strdup_printf(HERBST_HOOK_PROPERTY_FORMAT, j);
+    }
+    XInternAtoms(g_display, names, count, False, atoms);
+    for (i = 0; i < count; i++) {
+        // the table takes the ownership of the name
+        g_hash_table_insert(g_atoms, names[i], GSIZE_TO_POINTER(atoms[i]));
+    }
+    g_free(names);
+    g_free(atoms);
+}
+
+void atoms_destroy() {
+    g_hash_table_destroy(g_atoms);
+    g_atoms = NULL;
+}
+
+Atom atom_lookup(const char* name) {
+    // interned atoms are never None, so NULL means not cached yet
+    gpointer atom = g_hash_table_lookup(g_atoms, name);
+    if (atom) {
+        return (Atom)GPOINTER_TO_SIZE(atom);
+    }
+    Atom result = XInternAtom(g_display, name, False);
+    g_hash_table_insert(g_atoms, g_strdup(name), GSIZE_TO_POINTER(result));
+    return result;
+}
 
 time_t get_monotonic_timestamp() {
     struct timespec ts;
@@ -88,7 +145,8 @@ GString* window_property_to_g_string(Display* dpy, Window window, Atom atom) {
     }
     // convert text property to a gstring
     if (prop.encoding == XA_STRING
-        || prop.encoding == XInternAtom(dpy, "UTF8_STRING", False)) {
+        || prop.encoding == (dpy == g_display ? ATOM("UTF8_STRING")
+                             : XInternAtom(dpy, "UTF8_STRING", False))) {
         result = g_string_new((char*)prop.value);
     } else {
         if (XmbTextPropertyToTextList(dpy, &prop, &list, &n) >= Success
@@ -124,6 +182,19 @@ GString* window_instance_to_g_string(Display* dpy, Window window) {
     return string;
 }
 
+void window_class_hint_to_g_strings(Display* dpy, Window window,
+                                    GString** res_class, GString** res_name) {
+    XClassHint hint;
+    if (0 == XGetClassHint(dpy, window, &hint)) {
+        *res_class = g_string_new("");
+        *res_name = g_string_new("");
+        return;
+    }
+    *res_class = g_string_new(hint.res_class ? hint.res_class : "");
+    *res_name = g_string_new(hint.res_name ? hint.res_name : "");
+    if (hint.res_name) XFree(hint.res_name);
+    if (hint.res_class) XFree(hint.res_class);
+}
 
 bool is_herbstluft_window(Display* dpy, Window window) {
     GString* string = window_class_to_g_string(dpy, window);
@@ -36,11 +36,19 @@ void die(const char *errstr, ...);
 HSColor getcolor(const char *colstr);
 bool getcolor_error(const char *colstr, HSColor* color);
 
-#define ATOM(A) XInternAtom(g_display, (A), False)
+// interned atoms are cached, so only the first lookup of an atom that was not
+// prefetched by atoms_init() needs a roundtrip to the X server
+#define ATOM(A) atom_lookup(A)
+Atom atom_lookup(const char* name);
+void atoms_init();
+void atoms_destroy();
 
 GString* window_property_to_g_string(Display* dpy, Window window, Atom atom);
 GString* window_class_to_g_string(Display* dpy, Window window);
 GString* window_instance_to_g_string(Display* dpy, Window window);
+// fetches class and instance with a single request, both are never NULL
+void window_class_hint_to_g_strings(Display* dpy, Window window,
+                                    GString** res_class, GString** res_name);
 int window_pid(Display* dpy, Window window);
 
 typedef void* HSTree;